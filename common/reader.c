@@ -0,0 +1,426 @@
+// Flaga potrzebna do poprawnego działania funkcji read i nanosleep
+#define _GNU_SOURCE
+
+#include "reader.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+// Stała zwracana po wczytaniu ostatniego wiersza, tak jak przez getline
+#define END (-1)
+
+// Liczba prób oddania procesora przed krótkim uśpieniem wątku
+#define SPIN_LIMIT 64
+
+// Czas uśpienia wątku czekającego na drugi wątek (w nanosekundach)
+#define BACKOFF_NS 50000
+
+// Pusty fragment kończący ostatni wiersz danych bez znaku nowej linii
+static char emptyPart[1];
+
+/**
+ * Funkcja, w której wątek czeka na postęp drugiego wątku.
+ * Najpierw oddaje procesor, a po wielu nieudanych próbach krótko zasypia,
+ * aby nie zajmować rdzenia, gdy dane napływają powoli.
+ * spins - liczba dotychczasowych prób czekania
+ */
+static void backoff(size_t *spins) {
+    if (*spins < SPIN_LIMIT) {
+        sched_yield();
+        ++*spins;
+    }
+    else {
+        struct timespec pause = {0, BACKOFF_NS};
+        nanosleep(&pause, NULL);
+    }
+}
+
+/**
+ * Funkcja wypełniająca bufor danymi z deskryptora czytnika.
+ * Zwraca liczbę wczytanych bajtów, a 0 po dotarciu do końca danych.
+ * reader - czytnik
+ * buffer - bufor do wypełnienia
+ */
+static size_t fillBuffer(lineReader *reader, readerBuffer *buffer) {
+    ssize_t count;
+
+    do {
+        if (reader->positional)
+            count = pread(reader->fd, buffer->data, READER_BUFFER_SIZE,
+                          reader->offset);
+        else
+            count = read(reader->fd, buffer->data, READER_BUFFER_SIZE);
+    } while (count < 0 && errno == EINTR);
+
+    if (count > 0)
+        reader->offset += count;
+
+    // Błąd odczytu traktowany jest tak samo jak koniec danych
+    buffer->size = count > 0 ? (size_t) count : 0;
+    return buffer->size;
+}
+
+/**
+ * Główna funkcja wątku wczytującego.
+ * Wypełnia kolejne wolne bufory pierścienia i publikuje je konsumentowi.
+ * Gdy pierścień jest pełny, czeka na zwolnienie bufora przez konsumenta.
+ * arg - czytnik
+ */
+static void *produce(void *arg) {
+    lineReader *reader = arg;
+    size_t head = atomic_load_explicit(&reader->head, memory_order_relaxed);
+    size_t spins;
+
+    while (!atomic_load_explicit(&reader->stop, memory_order_relaxed)) {
+        spins = 0;
+
+        // Backpressure - czekanie, aż konsument zwolni najstarszy bufor
+        while (head - atomic_load_explicit(&reader->tail, memory_order_acquire)
+               >= READER_RING_SIZE) {
+            if (atomic_load_explicit(&reader->stop, memory_order_relaxed))
+                return NULL;
+
+            backoff(&spins);
+        }
+
+        if (fillBuffer(reader, &reader->ring[head % READER_RING_SIZE]) == 0) {
+            if (!reader->follow)
+                break;
+
+            // W trybie śledzenia koniec pliku oznacza tylko brak nowych danych
+            struct timespec pause = {0, READER_FOLLOW_NS};
+            nanosleep(&pause, NULL);
+            continue;
+        }
+
+        atomic_store_explicit(&reader->head, ++head, memory_order_release);
+    }
+
+    atomic_store_explicit(&reader->finished, true, memory_order_release);
+    return NULL;
+}
+
+/**
+ * Funkcja tworząca czytnik i uruchamiająca wątek wczytujący dane.
+ * fd - deskryptor, z którego czytane są dane
+ * positional - czy czytać funkcją pread
+ * offset - miejsce w pliku, od którego czytać przy pread
+ * follow - czy czekać na dane dopisywane na końcu pliku
+ */
+static lineReader *createReader(int fd, bool positional, off_t offset,
+                                bool follow) {
+    lineReader *reader = malloc(sizeof(lineReader));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (reader == NULL)
+        exit(1);
+
+    reader->fd = fd;
+    reader->positional = positional;
+    reader->offset = offset;
+    reader->follow = follow;
+    atomic_init(&reader->head, 0);
+    atomic_init(&reader->tail, 0);
+    atomic_init(&reader->finished, false);
+    atomic_init(&reader->stop, false);
+    reader->holding = false;
+    reader->position = 0;
+    reader->pending = false;
+    reader->partial = false;
+    reader->terminated = true;
+    reader->lines = 0;
+    reader->carry = NULL;
+    reader->carrySize = 0;
+    reader->carryMax = 0;
+
+    for (size_t i = 0; i < READER_RING_SIZE; i++) {
+        reader->ring[i].data = malloc(READER_BUFFER_SIZE);
+        reader->ring[i].size = 0;
+
+        if (reader->ring[i].data == NULL)
+            exit(1);
+    }
+
+    if (pthread_create(&reader->thread, NULL, produce, reader) != 0)
+        exit(1);
+
+    return reader;
+}
+
+/**
+ * Funkcja tworząca czytnik danych z deskryptora, czytający funkcją read.
+ * fd - deskryptor, z którego czytane są dane
+ */
+lineReader *readerCreate(int fd) {
+    return createReader(fd, false, 0, false);
+}
+
+/**
+ * Funkcja tworząca czytnik pliku od zadanego miejsca. Czyta funkcją pread,
+ * więc kilka procesów może niezależnie czytać ten sam otwarty plik.
+ * fd - deskryptor pliku
+ * offset - miejsce, od którego czytać
+ */
+lineReader *readerCreateAt(int fd, off_t offset) {
+    return createReader(fd, true, offset, false);
+}
+
+/**
+ * Funkcja tworząca czytnik pliku, który po dotarciu do końca pliku czeka
+ * na dopisywane dane, tak jak tail -f. Czytnik nigdy nie zwraca końca
+ * danych, a gdy pełnego wiersza jeszcze nie ma, zwraca READER_AGAIN.
+ * fd - deskryptor pliku
+ */
+lineReader *readerCreateFollowing(int fd) {
+    return createReader(fd, false, 0, true);
+}
+
+/**
+ * Funkcja zwracająca konsumentowi kolejny wypełniony bufor.
+ * Zwalnia poprzednio używany bufor i czeka, aż wątek wczytujący dostarczy
+ * następny. Zwraca NULL, gdy dane się skończyły, a w trybie śledzenia
+ * także wtedy, gdy nowe dane jeszcze nie zostały wczytane.
+ * reader - czytnik
+ */
+static readerBuffer *nextBuffer(lineReader *reader) {
+    size_t tail = atomic_load_explicit(&reader->tail, memory_order_relaxed);
+    size_t spins = 0;
+
+    if (reader->holding) {
+        atomic_store_explicit(&reader->tail, ++tail, memory_order_release);
+        reader->holding = false;
+    }
+
+    while (atomic_load_explicit(&reader->head, memory_order_acquire) == tail) {
+        // Flagę trzeba sprawdzić przed ponownym odczytem head, aby nie
+        // przeoczyć bufora opublikowanego tuż przed końcem pracy wątku
+        if (atomic_load_explicit(&reader->finished, memory_order_acquire)) {
+            if (atomic_load_explicit(&reader->head, memory_order_acquire)
+                == tail)
+                return NULL;
+            else
+                break;
+        }
+
+        if (reader->follow)
+            return NULL;
+
+        backoff(&spins);
+    }
+
+    reader->holding = true;
+    reader->position = 0;
+    return &reader->ring[tail % READER_RING_SIZE];
+}
+
+/**
+ * Funkcja dopisująca fragment wiersza do bufora carry.
+ * reader - czytnik
+ * data - początek fragmentu
+ * size - długość fragmentu
+ */
+static void appendCarry(lineReader *reader, const char *data, size_t size) {
+    if (reader->carrySize + size + 1 > reader->carryMax) {
+        reader->carryMax = 2 * (reader->carrySize + size + 1);
+        reader->carry = realloc(reader->carry, reader->carryMax);
+
+        // Awaryjne wyjście z programu w przypadku braku pamięci
+        if (reader->carry == NULL)
+            exit(1);
+    }
+
+    memcpy(reader->carry + reader->carrySize, data, size);
+    reader->carrySize += size;
+}
+
+/**
+ * Funkcja zwracająca kolejny wiersz danych wejściowych.
+ * Tak jak getline zwraca liczbę bajtów wiersza razem ze znakiem nowej linii,
+ * a po dotarciu do końca danych -1. Znak '\n' jest zastępowany znakiem '\0',
+ * a wiersz bez '\n' na końcu jest zakończony dodatkowym '\0'. Jeśli wiersz
+ * mieści się w jednym buforze, zwracany jest wskaźnik do jego wnętrza - bez
+ * kopiowania. Wiersze rozciągające się na kilka buforów są sklejane w buforze
+ * carry. Wskaźnik jest ważny do następnego wywołania funkcji.
+ * W trybie śledzenia wiersz bez '\n' czeka w buforze carry na dokończenie,
+ * a funkcja zwraca wtedy READER_AGAIN.
+ * reader - czytnik
+ * line - miejsce na wskaźnik do wiersza
+ */
+ssize_t readerGetLine(lineReader *reader, char **line) {
+    readerBuffer *buffer = NULL;
+    char *start, *newline;
+    size_t rest;
+
+    if (reader->holding) {
+        buffer = &reader->ring[atomic_load_explicit(&reader->tail,
+                                                    memory_order_relaxed)
+                               % READER_RING_SIZE];
+    }
+
+    // Niedokończony wiersz z poprzedniego wywołania jest kontynuowany
+    if (!reader->pending)
+        reader->carrySize = 0;
+
+    reader->pending = false;
+
+    while (true) {
+        if (buffer == NULL || reader->position == buffer->size) {
+            buffer = nextBuffer(reader);
+
+            if (buffer == NULL && reader->follow) {
+                reader->pending = true;
+                return READER_AGAIN;
+            }
+
+            if (buffer == NULL)
+                break;
+        }
+
+        start = buffer->data + reader->position;
+        rest = buffer->size - reader->position;
+        newline = memchr(start, '\n', rest);
+
+        if (newline != NULL) {
+            size_t size = (size_t) (newline - start) + 1;
+            reader->position += size;
+
+            reader->terminated = true;
+            reader->lines++;
+
+            if (reader->carrySize == 0) {
+                *newline = '\0';
+                *line = start;
+                return (ssize_t) size;
+            }
+
+            appendCarry(reader, start, size);
+            reader->carry[reader->carrySize - 1] = '\0';
+            *line = reader->carry;
+            return (ssize_t) reader->carrySize;
+        }
+
+        // Wiersz nie kończy się w tym buforze - kopiowanie jego początku
+        appendCarry(reader, start, rest);
+        reader->position = buffer->size;
+    }
+
+    // Ostatni wiersz danych bez znaku nowej linii
+    if (reader->carrySize > 0) {
+        reader->terminated = false;
+        reader->lines++;
+        reader->carry[reader->carrySize] = '\0';
+        *line = reader->carry;
+        return (ssize_t) reader->carrySize;
+    }
+
+    return END;
+}
+
+/**
+ * Funkcja zwracająca widok kolejnego wiersza - bez kopiowania, jeśli wiersz
+ * mieści się w jednym buforze. Długość nie obejmuje znaku nowej linii, także
+ * gdy ostatni wiersz danych go nie ma, a numer wiersza jest liczony przez
+ * czytnik. Zwraca fałsz po dotarciu do końca danych, a w trybie śledzenia
+ * także wtedy, gdy pełnego wiersza jeszcze nie ma. Widok jest ważny do
+ * następnego wywołania funkcji czytnika.
+ * reader - czytnik
+ * view - miejsce na widok wiersza
+ */
+bool readerNextLine(lineReader *reader, lineView *view) {
+    ssize_t read = readerGetLine(reader, &view->data);
+
+    if (read < 0)
+        return false;
+
+    view->length = reader->terminated ? (size_t) read - 1 : (size_t) read;
+    view->number = reader->lines;
+    return true;
+}
+
+/**
+ * Funkcja zwracająca kolejny fragment wiersza - wskaźnik do wnętrza bufora
+ * pierścienia, bez kopiowania. Fragment kończy się na znaku nowej linii
+ * (zastępowanym znakiem '\0' i wliczanym do zwracanej długości) albo na końcu
+ * bufora. Wtedy *whole jest fałszem, a dalsza część wiersza przychodzi
+ * w kolejnych wywołaniach. Wiersz bez '\n' na końcu danych kończy pusty
+ * fragment. Dzięki temu dowolnie długi wiersz nie musi
+ * mieścić się w pamięci. Po dotarciu do końca danych zwraca -1. W trybie
+ * śledzenia zwraca zawsze całe wiersze, tak jak readerGetLine.
+ * Wskaźnik jest ważny do następnego wywołania funkcji.
+ * reader - czytnik
+ * part - miejsce na wskaźnik do fragmentu
+ * whole - miejsce na informację, czy fragment kończy wiersz
+ */
+ssize_t readerGetPart(lineReader *reader, char **part, bool *whole) {
+    readerBuffer *buffer = NULL;
+    char *start, *newline;
+    size_t rest, size;
+
+    // Niedokończony wiersz trybu śledzenia czeka w buforze carry
+    if (reader->follow) {
+        *whole = true;
+        return readerGetLine(reader, part);
+    }
+
+    if (reader->holding) {
+        buffer = &reader->ring[atomic_load_explicit(&reader->tail,
+                                                    memory_order_relaxed)
+                               % READER_RING_SIZE];
+    }
+
+    if (buffer == NULL || reader->position == buffer->size) {
+        buffer = nextBuffer(reader);
+
+        if (buffer == NULL) {
+            if (!reader->partial)
+                return END;
+
+            // Ostatni wiersz danych bez znaku nowej linii
+            reader->partial = false;
+            reader->terminated = false;
+            reader->lines++;
+            *part = emptyPart;
+            *whole = true;
+            return 0;
+        }
+    }
+
+    start = buffer->data + reader->position;
+    rest = buffer->size - reader->position;
+    newline = memchr(start, '\n', rest);
+    *part = start;
+
+    if (newline == NULL) {
+        reader->position = buffer->size;
+        reader->partial = true;
+        *whole = false;
+        return (ssize_t) rest;
+    }
+
+    size = (size_t) (newline - start) + 1;
+    reader->position += size;
+    reader->partial = false;
+    reader->terminated = true;
+    reader->lines++;
+    *newline = '\0';
+    *whole = true;
+    return (ssize_t) size;
+}
+
+/**
+ * Funkcja kończąca pracę wątku wczytującego i zwalniająca pamięć czytnika.
+ * reader - czytnik
+ */
+void readerDestroy(lineReader *reader) {
+    atomic_store_explicit(&reader->stop, true, memory_order_relaxed);
+    pthread_join(reader->thread, NULL);
+
+    for (size_t i = 0; i < READER_RING_SIZE; i++)
+        free(reader->ring[i].data);
+
+    free(reader->carry);
+    free(reader);
+}
@@ -0,0 +1,115 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#ifndef READER_H
+#define READER_H
+
+// Rozmiar pojedynczego bufora wczytywanych danych
+#define READER_BUFFER_SIZE (1 << 20)
+
+// Liczba buforów w pierścieniu współdzielonym przez oba wątki
+#define READER_RING_SIZE 4
+
+// Wartość zwracana w trybie śledzenia, gdy nie ma jeszcze pełnego wiersza
+#define READER_AGAIN (-2)
+
+// Czas między próbami odczytu dopisanych danych w trybie śledzenia
+// (w nanosekundach)
+#define READER_FOLLOW_NS 100000000
+
+/**
+ * Bufor z pierścienia czytnika.
+ * data - wczytane bajty
+ * size - liczba wczytanych bajtów
+ */
+struct readerBuffer {
+    char *data;
+    size_t size;
+};
+typedef struct readerBuffer readerBuffer;
+
+/**
+ * Widok wiersza danych wejściowych, wskazujący wnętrze bufora czytnika.
+ * data - znaki wiersza, zakończone znakiem '\0' w miejscu znaku nowej linii
+ * length - liczba znaków wiersza, bez znaku nowej linii
+ * number - numer wiersza, liczony od 1
+ */
+struct lineView {
+    char *data;
+    size_t length;
+    size_t number;
+};
+typedef struct lineView lineView;
+
+/**
+ * Czytnik wierszy, w którym osobny wątek wypełnia pierścień dużych buforów,
+ * a wątek parsujący przetwarza wcześniej wczytane dane.
+ * Przekazywanie buforów między wątkami odbywa się bez blokad - producent
+ * przesuwa jedynie licznik head, a konsument licznik tail.
+ * fd - deskryptor, z którego czytane są dane
+ * positional - czy dane są czytane funkcją pread od zadanego miejsca, bez
+ *              zmieniania pozycji w pliku współdzielonej z innymi procesami
+ * offset - miejsce w pliku, od którego czytany jest kolejny bufor
+ * follow - czy po dotarciu do końca pliku czekać na dopisywane dane
+ * thread - wątek wczytujący dane
+ * ring - pierścień buforów
+ * head - liczba buforów wypełnionych przez wątek wczytujący
+ * tail - liczba buforów zwolnionych przez wątek parsujący
+ * finished - czy wątek wczytujący dotarł do końca danych
+ * stop - prośba konsumenta o zakończenie pracy wątku wczytującego
+ * holding - czy konsument korzysta obecnie z bufora ring[tail]
+ * position - pozycja konsumenta w obecnym buforze
+ * pending - czy bufor carry trzyma niedokończony wiersz z trybu śledzenia
+ * partial - czy ostatnio zwrócony fragment wiersza nie kończył wiersza
+ * terminated - czy ostatni zwrócony wiersz kończył się znakiem nowej linii
+ * lines - liczba wierszy zwróconych w całości albo dokończonych fragmentem
+ * carry - bufor na wiersze rozciągające się na kilka buforów pierścienia
+ * carrySize, carryMax - zajęta i przydzielona pamięć bufora carry
+ */
+struct lineReader {
+    int fd;
+    bool positional;
+    off_t offset;
+    bool follow;
+    pthread_t thread;
+    readerBuffer ring[READER_RING_SIZE];
+    atomic_size_t head;
+    atomic_size_t tail;
+    atomic_bool finished;
+    atomic_bool stop;
+    bool holding;
+    size_t position;
+    bool pending;
+    bool partial;
+    bool terminated;
+    size_t lines;
+    char *carry;
+    size_t carrySize, carryMax;
+};
+typedef struct lineReader lineReader;
+
+// Funkcja tworząca czytnik i uruchamiająca wątek wczytujący dane z fd
+extern lineReader *readerCreate(int fd);
+
+// Funkcja tworząca czytnik pliku od zadanego miejsca, czytający przez pread
+extern lineReader *readerCreateAt(int fd, off_t offset);
+
+// Funkcja tworząca czytnik pliku, który czeka na dopisywane dane
+extern lineReader *readerCreateFollowing(int fd);
+
+// Funkcja zwracająca kolejny wiersz w stylu getline
+extern ssize_t readerGetLine(lineReader *reader, char **line);
+
+// Funkcja zwracająca widok kolejnego wiersza razem z jego numerem
+extern bool readerNextLine(lineReader *reader, lineView *view);
+
+// Funkcja zwracająca kolejny fragment wiersza bez kopiowania go
+extern ssize_t readerGetPart(lineReader *reader, char **part, bool *whole);
+
+// Funkcja kończąca pracę wątku wczytującego i zwalniająca czytnik
+extern void readerDestroy(lineReader *reader);
+
+#endif //READER_H
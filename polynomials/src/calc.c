@@ -5,14 +5,13 @@
  *  @date 2021
  */
 
-/** Flaga potrzebna do poprawnego działania funkcji getline */
-#define _GNU_SOURCE
-
 #include "poly.h"
+#include "reader.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <unistd.h>
 
 /**
  * Makro sprawdzające dany wskaźnik, czy nie ma błędu braku pamięci.
@@ -35,16 +34,13 @@
 /** Początkowy rozmiar dynamicznych struktur danych z typem char. */
 #define DEFAULT_SIZE_CHAR 128
 
-/** Stała zwracana przez getline po wczytaniu ostatniego wiersza. */
-#define END (-1)
-
 /** Liczba wielomianów potrzebna do działania 1-argumentowego. */
 #define ONE_ARG_OP 1
 
 /** Liczba wielomianów potrzebna do działania 2-argumentowego. */
 #define TWO_ARG_OP 2
 
-/** Stała zwracana przez strcmp, jeśli dwa stringi są identyczne. */
+/** Stała zwracana przez memcmp, jeśli dwie tablice są identyczne. */
 #define IDENTICAL 0
 
 /**
@@ -583,6 +579,17 @@ static void ProcessCompose(Stack *s, char *line, size_t size, size_t count) {
     }
 }
 
+/**
+ * Sprawdza czy tablica znaków jest dokładnie nazwą danej komendy.
+ * @param[in] line : tablica znaków z komendą
+ * @param[in] size : rozmiar tablicy
+ * @param[in] name : nazwa komendy
+ * @return prawda jeśli tablica znaków jest nazwą komendy, fałsz wpp
+ */
+static bool IsCommandName(char *line, size_t size, const char *name) {
+    return size == strlen(name) && memcmp(line, name, size) == IDENTICAL;
+}
+
 /**
  * Rozpoznaje, przetwarza i wykonuje komendę.
  * @param[in] s : stos
@@ -593,34 +600,34 @@ static void ProcessCompose(Stack *s, char *line, size_t size, size_t count) {
 static void ProcessCommand(Stack *s, char *line, size_t size, size_t count) {
     assert(line != NULL);
 
-    if (strcmp(line, "ZERO\n") == IDENTICAL)
+    if (IsCommandName(line, size, "ZERO"))
         ProcessZero(s);
-    else if (strcmp(line, "IS_COEFF\n") == IDENTICAL)
+    else if (IsCommandName(line, size, "IS_COEFF"))
         ProcessIsCoeff(s, count);
-    else if (strcmp(line, "IS_ZERO\n") == IDENTICAL)
+    else if (IsCommandName(line, size, "IS_ZERO"))
         ProcessIsZero(s, count);
-    else if (strcmp(line, "CLONE\n") == IDENTICAL)
+    else if (IsCommandName(line, size, "CLONE"))
         ProcessClone(s, count);
-    else if (strcmp(line, "ADD\n") == IDENTICAL)
+    else if (IsCommandName(line, size, "ADD"))
         ProcessAdd(s, count);
-    else if (strcmp(line, "MUL\n") == IDENTICAL)
+    else if (IsCommandName(line, size, "MUL"))
         ProcessMul(s, count);
-    else if (strcmp(line, "NEG\n") == IDENTICAL)
+    else if (IsCommandName(line, size, "NEG"))
         ProcessNeg(s, count);
-    else if (strcmp(line, "SUB\n") == IDENTICAL)
+    else if (IsCommandName(line, size, "SUB"))
         ProcessSub(s, count);
-    else if (strcmp(line, "IS_EQ\n") == IDENTICAL)
+    else if (IsCommandName(line, size, "IS_EQ"))
         ProcessIsEq(s, count);
-    else if (strcmp(line, "DEG\n") == IDENTICAL)
+    else if (IsCommandName(line, size, "DEG"))
         ProcessDeg(s, count);
     else if (size > 5 && line[0] == 'D' && line[1] == 'E' && line[2] == 'G'
              && line[3] == '_' && line[4] == 'B' && line[5] == 'Y')
         ProcessDegBy(s, line, size, count);
     else if (size > 1 && line[0] == 'A' && line[1] == 'T')
         ProcessAt(s, line, size, count);
-    else if (strcmp(line, "PRINT\n") == IDENTICAL)
+    else if (IsCommandName(line, size, "PRINT"))
         ProcessPrint(s, count);
-    else if (strcmp(line, "POP\n") == IDENTICAL)
+    else if (IsCommandName(line, size, "POP"))
         ProcessPop(s, count);
     else if (size > 6 && line[0] == 'C' && line[1] == 'O' && line[2] == 'M'
              && line[3] == 'P' && line[4] == 'O' && line[5] == 'S'
@@ -983,27 +990,21 @@ static bool IgnoreLine(char *line, size_t size) {
 static void LoadInput(Stack *stack) {
     assert(stack != NULL);
 
-    char *line = NULL;
-    size_t buffSize, count = 1;
-    ssize_t read;
+    lineReader *reader = readerCreate(STDIN_FILENO);
+    lineView view;
 
-    while ((read = getline(&line, &buffSize, stdin)) != END) {
-        CHECK_PTR(line);
+    // wiersze są widokami na bufory czytnika, bez znaku nowej linii
+    while (readerNextLine(reader, &view)) {
+        char *line = view.data;
+        size_t size = view.length, count = view.number;
 
-        // jeśli linia nie ma na końcu znaku nowej linii, to jest doklejany
-        if (line[read - 1] != '\n') {
-            ++read;
-            strcat(line, "\n");
-            CHECK_PTR(line);
-        }
-
-        if (!IgnoreLine(line, read - 1)) {
+        if (!IgnoreLine(line, size)) {
             if (IsCommand(line))
-                ProcessCommand(stack, line, read - 1, count);
-            else if (!CorrectPoly(line, read - 1))
+                ProcessCommand(stack, line, size, count);
+            else if (!CorrectPoly(line, size))
                 fprintf(stderr, "ERROR %zu WRONG POLY\n", count);
             else
-                PushS(stack, LoadPoly(line, read - 1));
+                PushS(stack, LoadPoly(line, size));
         }
 
         // jeśli połowa stosu jest pusta, to jest o połowę zmniejszany
@@ -1013,11 +1014,9 @@ static void LoadInput(Stack *stack) {
                     realloc(stack->arr, stack->maxSize * sizeof(Poly));
             CHECK_PTR(stack->arr);
         }
-
-        ++count;
     }
 
-    free(line);
+    readerDestroy(reader);
 }
 
 /**
@@ -0,0 +1,214 @@
+// Flaga potrzebna do poprawnego działania funkcji mmap
+#define _GNU_SOURCE
+
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/**
+ * Funkcja zaokrąglająca liczbę w górę do wielokrotności wyrównania.
+ * x - liczba do zaokrąglenia
+ * align - wyrównanie, będące potęgą dwójki
+ */
+static size_t alignUp(size_t x, size_t align) {
+    return (x + align - 1) & ~(align - 1);
+}
+
+/**
+ * Funkcja tworząca pustą arenę.
+ * Bloki pamięci są pobierane dopiero przy pierwszym przydziale.
+ */
+arena *arenaCreate(void) {
+    arena *a = malloc(sizeof(arena));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (a == NULL)
+        exit(1);
+
+    a->current = NULL;
+    a->last = NULL;
+    memset(&a->stats, 0, sizeof(arenaStats));
+
+    return a;
+}
+
+/**
+ * Funkcja pobierająca z systemu nowy blok, mieszczący co najmniej size bajtów.
+ * a - arena
+ * size - liczba bajtów, które muszą zmieścić się w bloku
+ * align - wyrównanie, z jakim zostaną przydzielone
+ */
+static void newChunk(arena *a, size_t size, size_t align) {
+    size_t chunkSize = alignUp(sizeof(arenaChunk), align) + size;
+
+    if (chunkSize < ARENA_CHUNK_SIZE)
+        chunkSize = ARENA_CHUNK_SIZE;
+
+    arenaChunk *chunk = mmap(NULL, chunkSize, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (chunk == MAP_FAILED)
+        exit(1);
+
+    chunk->next = a->current;
+    chunk->size = chunkSize;
+    chunk->used = sizeof(arenaChunk);
+    a->current = chunk;
+    a->last = NULL;
+
+    ++a->stats.chunks;
+    a->stats.reserved += chunkSize;
+}
+
+/**
+ * Funkcja przydzielająca pamięć z areny.
+ * Przesuwa wskaźnik w obecnym bloku, a gdy brakuje w nim miejsca, pobiera
+ * nowy blok. Awaryjnie kończy program w przypadku braku pamięci.
+ * a - arena
+ * size - liczba bajtów do przydzielenia
+ * align - wyrównanie przydziału, będące potęgą dwójki
+ */
+void *arenaAlloc(arena *a, size_t size, size_t align) {
+    arenaChunk *chunk = a->current;
+    size_t start;
+
+    if (chunk == NULL
+        || alignUp(chunk->used, align) + size > chunk->size) {
+        newChunk(a, size, align);
+        chunk = a->current;
+    }
+
+    start = alignUp(chunk->used, align);
+    a->stats.used += start - chunk->used + size;
+    ++a->stats.allocations;
+
+    chunk->used = start + size;
+    a->last = (char *) chunk + start;
+
+    return a->last;
+}
+
+/**
+ * Funkcja powiększająca przydział z areny.
+ * Jeśli przydział jest ostatnim w obecnym bloku i mieści się w nim po
+ * powiększeniu, rośnie w miejscu. W przeciwnym wypadku jest kopiowany,
+ * a dotychczasowa pamięć pozostaje nieużywana do końca życia areny.
+ * a - arena
+ * x - powiększany przydział lub NULL
+ * oldSize - dotychczasowy rozmiar przydziału
+ * newSize - nowy rozmiar przydziału
+ * align - wyrównanie przydziału
+ */
+void *arenaGrow(arena *a, void *x, size_t oldSize, size_t newSize,
+                size_t align) {
+    arenaChunk *chunk = a->current;
+
+    if (x != NULL && x == a->last
+        && (size_t) ((char *) x - (char *) chunk) + newSize <= chunk->size) {
+        chunk->used += newSize - oldSize;
+        a->stats.used += newSize - oldSize;
+        ++a->stats.allocations;
+        return x;
+    }
+
+    void *y = arenaAlloc(a, newSize, align);
+
+    if (x != NULL) {
+        memcpy(y, x, oldSize);
+        a->stats.abandoned += oldSize;
+    }
+
+    return y;
+}
+
+/**
+ * Funkcja zapamiętująca obecny stan areny.
+ * a - arena
+ */
+arenaMark arenaGetMark(arena *a) {
+    arenaMark mark;
+    mark.chunk = a->current;
+    mark.used = a->current != NULL ? a->current->used : 0;
+    mark.stats = a->stats;
+    return mark;
+}
+
+/**
+ * Funkcja zwalniająca wszystkie przydziały wykonane od zapamiętanego stanu.
+ * Bloki pobrane później są oddawane systemowi. Przydziały sprzed znacznika
+ * pozostają nienaruszone.
+ * a - arena
+ * mark - stan zwrócony przez arenaGetMark
+ */
+void arenaRelease(arena *a, arenaMark mark) {
+    while (a->current != mark.chunk) {
+        arenaChunk *next = a->current->next;
+        munmap(a->current, a->current->size);
+        a->current = next;
+    }
+
+    if (a->current != NULL)
+        a->current->used = mark.used;
+
+    a->last = NULL;
+    a->stats = mark.stats;
+}
+
+/**
+ * Funkcja przejmująca wszystkie bloki innej areny (np. areny wątku) razem
+ * z jej statystykami i zwalniająca samą arenę. Przejęte bloki są wstawiane
+ * za bieżącym blokiem, więc przydziały z areny a trwają w nim dalej.
+ * Znaczniki zapamiętane przed przejęciem tracą ważność.
+ * a - arena przejmująca bloki
+ * other - arena oddająca bloki
+ */
+void arenaAdopt(arena *a, arena *other) {
+    arenaChunk *tail = other->current;
+
+    if (tail != NULL) {
+        while (tail->next != NULL)
+            tail = tail->next;
+
+        if (a->current != NULL) {
+            tail->next = a->current->next;
+            a->current->next = other->current;
+        }
+        else {
+            a->current = other->current;
+            a->last = NULL;
+        }
+    }
+
+    a->stats.chunks += other->stats.chunks;
+    a->stats.reserved += other->stats.reserved;
+    a->stats.used += other->stats.used;
+    a->stats.allocations += other->stats.allocations;
+    a->stats.abandoned += other->stats.abandoned;
+    free(other);
+}
+
+/**
+ * Funkcja zwracająca statystyki przydziałów areny.
+ * a - arena
+ */
+arenaStats arenaGetStats(arena *a) {
+    return a->stats;
+}
+
+/**
+ * Funkcja oddająca systemowi wszystkie bloki areny i samą arenę.
+ * a - arena
+ */
+void arenaDestroy(arena *a) {
+    arenaChunk *chunk = a->current;
+
+    while (chunk != NULL) {
+        arenaChunk *next = chunk->next;
+        munmap(chunk, chunk->size);
+        chunk = next;
+    }
+
+    free(a);
+}
@@ -0,0 +1,92 @@
+#include <stddef.h>
+
+#ifndef ARENA_H
+#define ARENA_H
+
+// Minimalny rozmiar bloku pamięci pobieranego z systemu przez mmap
+#define ARENA_CHUNK_SIZE (4 << 20)
+
+/**
+ * Blok pamięci areny, pobrany z systemu w całości przez mmap.
+ * next - poprzednio pobrany blok
+ * size - rozmiar bloku razem z nagłówkiem
+ * used - liczba zajętych bajtów bloku razem z nagłówkiem
+ */
+struct arenaChunk {
+    struct arenaChunk *next;
+    size_t size;
+    size_t used;
+};
+typedef struct arenaChunk arenaChunk;
+
+/**
+ * Statystyki przydziałów areny.
+ * chunks - liczba bloków pobranych z systemu
+ * reserved - łączny rozmiar bloków
+ * used - liczba bajtów zajętych przez przydziały (z wyrównaniem)
+ * allocations - liczba przydziałów, wliczając powiększenia tablic
+ * abandoned - bajty pozostawione przez tablice przeniesione przy powiększaniu
+ */
+struct arenaStats {
+    size_t chunks;
+    size_t reserved;
+    size_t used;
+    size_t allocations;
+    size_t abandoned;
+};
+typedef struct arenaStats arenaStats;
+
+/**
+ * Znacznik stanu areny, do którego można ją cofnąć.
+ * chunk - ówczesny bieżący blok
+ * used - ówczesna liczba zajętych bajtów bloku
+ * stats - ówczesne statystyki
+ */
+struct arenaMark {
+    arenaChunk *chunk;
+    size_t used;
+    arenaStats stats;
+};
+typedef struct arenaMark arenaMark;
+
+/**
+ * Arena - alokator przesuwający wskaźnik w dużych blokach pamięci.
+ * Pojedynczych przydziałów nie zwalnia się - cała pamięć jest oddawana
+ * systemowi naraz, w czasie proporcjonalnym do liczby bloków.
+ * current - blok, z którego obecnie przydzielana jest pamięć
+ * last - początek ostatniego przydziału, który można powiększyć w miejscu
+ * stats - statystyki przydziałów
+ */
+struct arena {
+    arenaChunk *current;
+    char *last;
+    arenaStats stats;
+};
+typedef struct arena arena;
+
+// Funkcja tworząca pustą arenę
+extern arena *arenaCreate(void);
+
+// Funkcja przydzielająca pamięć o zadanym rozmiarze i wyrównaniu
+extern void *arenaAlloc(arena *a, size_t size, size_t align);
+
+// Funkcja powiększająca przydział, w miejscu, jeśli to możliwe
+extern void *arenaGrow(arena *a, void *x, size_t oldSize, size_t newSize,
+                       size_t align);
+
+// Funkcja zapamiętująca obecny stan areny
+extern arenaMark arenaGetMark(arena *a);
+
+// Funkcja zwalniająca wszystkie przydziały wykonane od zapamiętanego stanu
+extern void arenaRelease(arena *a, arenaMark mark);
+
+// Funkcja przejmująca wszystkie bloki innej areny i zwalniająca ją
+extern void arenaAdopt(arena *a, arena *other);
+
+// Funkcja zwracająca statystyki przydziałów areny
+extern arenaStats arenaGetStats(arena *a);
+
+// Funkcja oddająca systemowi całą pamięć areny
+extern void arenaDestroy(arena *a);
+
+#endif //ARENA_H
@@ -0,0 +1,175 @@
+/**
+ * Benchmark liczby przydziałów pamięci podczas parsowania.
+ * Generuje syntetyczne wiersze o zadanej liczbie słów każdego typu, parsuje
+ * je funkcją loadInput i zlicza wywołania malloc/realloc (przechwytywane
+ * opcją linkera --wrap) oraz przydziały z areny. Dla porównania wypisuje
+ * liczbę przydziałów, jakiej wymagałaby tablica rosnąca od zera według wzoru
+ * 1 + 2 * rozmiar. Bez liczby słów wypisuje zestawienie dla wierszy
+ * o 1..MAX_SWEEP słowach każdego typu, pokazujące, do jakiej długości
+ * wiersze nie przydzielają tablic słów wcale.
+ * Użycie: alloc_bench [liczba wierszy] [słów każdego typu w wierszu]
+ * Autor: Michał Skwarek
+ */
+
+#define _GNU_SOURCE
+
+#include "../multiset.h"
+#include "../parser.h"
+#include "../arena.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Liczba typów słów przechowywanych w multizbiorze
+#define TYPES 4
+
+// Największa liczba słów każdego typu w zestawieniu
+#define MAX_SWEEP 8
+
+static size_t mallocs, reallocs;
+
+extern void *__real_malloc(size_t size);
+extern void *__real_realloc(void *x, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    ++mallocs;
+    return __real_malloc(size);
+}
+
+void *__wrap_realloc(void *x, size_t size) {
+    ++reallocs;
+    return __real_realloc(x, size);
+}
+
+/**
+ * Funkcja zwracająca liczbę przydziałów tablicy z k elementami, gdy tablica
+ * rośnie od zera według wzoru 1 + 2 * rozmiar (1, 3, 7, 15, ...).
+ * k - liczba elementów
+ */
+static size_t legacyGrowths(size_t k) {
+    size_t reserved = 0, count = 0;
+
+    while (reserved < k) {
+        reserved = 1 + 2 * reserved;
+        ++count;
+    }
+
+    return count;
+}
+
+/**
+ * Funkcja zapisująca do pliku tymczasowego wiersze z k słowami każdego typu
+ * i podpinająca go jako standardowe wejście.
+ * lines - liczba wierszy
+ * k - liczba słów każdego typu w wierszu
+ */
+static void prepareInput(size_t lines, size_t k) {
+    FILE *file = tmpfile();
+
+    if (file == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < lines; i++) {
+        for (size_t j = 0; j < k; j++)
+            fprintf(file, "%zu -%zu %zu.5 word%zu ", i + j, j + 1, j, j);
+
+        fputc('\n', file);
+    }
+
+    fflush(file);
+    rewind(file);
+
+    if (dup2(fileno(file), STDIN_FILENO) < 0)
+        exit(1);
+}
+
+/**
+ * Funkcja parsująca wiersze z k słowami każdego typu i zwracająca liczbę
+ * przydziałów tablic słów z areny na wiersz. Każda "nieliczba" jest
+ * kopiowana do areny osobno, więc te przydziały nie są wliczane.
+ * lines - liczba wierszy
+ * k - liczba słów każdego typu w wierszu
+ * verbose - czy wypisać szczegółowe wyniki
+ */
+static double measureArrays(size_t lines, size_t k, bool verbose) {
+    size_t size;
+    struct timespec start, end;
+
+    prepareInput(lines, k);
+
+    multiset *text = malloc(DEFAULT_SIZE * sizeof(multiset));
+    arena *memory = arenaCreate();
+    if (text == NULL)
+        exit(1);
+
+    mallocs = reallocs = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    text = loadInput(text, &size, memory, processWord, 1);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    arenaStats stats = arenaGetStats(memory);
+    double arrays = (double) (stats.allocations - lines * k) / lines;
+
+    // Każda "nieliczba" wymaga osobnej kopii, niezależnie od tablic
+    size_t legacy = lines * (TYPES * legacyGrowths(k) + k);
+
+    if (verbose) {
+        printf("wiersze: %zu, slow kazdego typu: %zu, sizeof(multiset): %zu\n",
+               lines, k, sizeof(multiset));
+        printf("przydzialy (malloc + realloc): %zu + %zu, na wiersz: %.2f\n",
+               mallocs, reallocs, (double) (mallocs + reallocs) / lines);
+        printf("przydzialy z areny: %zu (tablic slow na wiersz: %.2f), "
+               "blokow: %zu (%zu B), zajete: %zu B, porzucone: %zu B\n",
+               stats.allocations, arrays, stats.chunks, stats.reserved,
+               stats.used, stats.abandoned);
+        printf("przydzialy przy wzroscie 1 + 2 * rozmiar: %zu, na wiersz: "
+               "%.2f\n", legacy, (double) legacy / lines);
+        printf("czas parsowania: %.3f s\n", (end.tv_sec - start.tv_sec)
+               + (end.tv_nsec - start.tv_nsec) / 1e9);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    arenaDestroy(memory);
+    free(text);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (verbose)
+        printf("wierszy: %zu, czas zwalniania: %.6f s\n", size,
+               (end.tv_sec - start.tv_sec)
+               + (end.tv_nsec - start.tv_nsec) / 1e9);
+
+    return arrays;
+}
+
+int main(int argc, char *argv[]) {
+    size_t lines = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000;
+
+    if (lines == 0) {
+        fprintf(stderr, "ERROR niepoprawne argumenty\n");
+        return 1;
+    }
+
+    if (argc > 2) {
+        measureArrays(lines, strtoull(argv[2], NULL, 10), true);
+        return 0;
+    }
+
+    // Bez liczby słów - zestawienie dla wierszy o 1..MAX_SWEEP słowach
+    // każdego typu. Tablice mieszczą się w multizbiorze, dopóki słów
+    // każdego typu jest nie więcej niż INLINE_*; dłuższe wiersze
+    // przydzielają tablice z areny
+    printf("sizeof(multiset): %zu, w strukturze: %d + %d liczb calkowitych, "
+           "%d zmiennoprzecinkowych, %d nieliczb\n", sizeof(multiset),
+           INLINE_INTS, INLINE_INTS, INLINE_FLOATS, INLINE_WORDS);
+    printf("slow kazdego typu | tablice z areny na wiersz | "
+           "przydzialy przy 1 + 2 * rozmiar\n");
+
+    for (size_t k = 1; k <= MAX_SWEEP; k++)
+        printf("%17zu | %25.2f | %31zu\n", k, measureArrays(lines, k, false),
+               TYPES * legacyGrowths(k));
+
+    return 0;
+}
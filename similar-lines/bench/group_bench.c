@@ -0,0 +1,142 @@
+/**
+ * Benchmark fazy szukania grup podobnych wierszy.
+ * Generuje wiersze należące do zadanej liczby różnych multizbiorów,
+ * rozrzucone pseudolosowo po danych, i porównuje dwie wersje pętli
+ * kwadratowej: dawną, która dla każdej pary wierszy wywołuje similarSets
+ * na pełnych multizbiorach, oraz findSimilar, która czyta tylko zwartą
+ * tablicę skrótów wierszy. Czas i sprzętowe liczniki (chybienia w L1D
+ * i LLC, o ile są dostępne) wypisuje moduł counters na stderr.
+ * Użycie: group_bench [liczba wierszy] [liczba różnych multizbiorów]
+ * Autor: Michał Skwarek
+ */
+
+#define _GNU_SOURCE
+
+#include "../multiset.h"
+#include "../parser.h"
+#include "../similar.h"
+#include "../arena.h"
+#include "../report.h"
+#include "../options.h"
+#include "../counters.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * Funkcja zapisująca do pliku tymczasowego wiersze należące do groups
+ * różnych multizbiorów i podpinająca go jako standardowe wejście.
+ * Słowa każdego wiersza są przestawione, aby wiersze jednej grupy różniły
+ * się przed posortowaniem.
+ * lines - liczba wierszy
+ * groups - liczba różnych multizbiorów
+ */
+static void prepareInput(size_t lines, size_t groups) {
+    FILE *file = tmpfile();
+    unsigned long long state = 88172645463325252ULL, g;
+
+    if (file == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < lines; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        g = state % groups;
+
+        if (i % 2 == 0)
+            fprintf(file, "%llu -%llu %llu.5 slowo%llu ala ma kota\n",
+                    g, g % 7 + 1, g % 3, g);
+        else
+            fprintf(file, "kota ma ala slowo%llu %llu.5 -%llu %llu\n",
+                    g, g % 3, g % 7 + 1, g);
+    }
+
+    fflush(file);
+    rewind(file);
+
+    if (dup2(fileno(file), STDIN_FILENO) < 0)
+        exit(1);
+}
+
+/**
+ * Dawna wersja findSimilar: każda para wierszy porównywana na pełnych
+ * multizbiorach, z osobną tablicą odwiedzonych wierszy.
+ * set - posortowane multizbiory
+ * size - liczba multizbiorów
+ * r - moduł wypisujący grupy
+ */
+static void findSimilarCold(multiset *set, size_t size, reporter *r) {
+    bool *visited = calloc(size + 1, sizeof(bool));
+    size_t *lines = malloc((size + 1) * sizeof(size_t));
+    size_t groupSize;
+
+    if (visited == NULL || lines == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < size; i++) {
+        if (!visited[i]) {
+            groupSize = 0;
+            lines[groupSize++] = set[i].lineCount;
+
+            for (size_t j = i + 1; j < size; j++) {
+                if (!visited[j] && similarSets(&set[i], &set[j])) {
+                    lines[groupSize++] = set[j].lineCount;
+                    visited[j] = true;
+                }
+            }
+
+            visited[i] = true;
+            reportGroup(r, lines, groupSize, &set[i]);
+        }
+    }
+
+    free(visited);
+    free(lines);
+}
+
+int main(int argc, char *argv[]) {
+    size_t lines = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000;
+    size_t groups = argc > 2 ? strtoull(argv[2], NULL, 10) : 2000;
+    int sink = open("/dev/null", O_WRONLY);
+    multiset *text = malloc(DEFAULT_SIZE * sizeof(multiset));
+    arena *memory = arenaCreate();
+    size_t size;
+    options opts;
+    reporter r;
+    counters c;
+
+    if (text == NULL || sink < 0 || lines == 0 || groups == 0)
+        exit(1);
+
+    // Domyślne opcje programu - grupy są wypisywane w formacie tekstowym
+    parseOptions(&opts, 1, argv);
+    prepareInput(lines, groups);
+    text = loadInput(text, &size, memory, processWord, 1);
+
+    printf("wiersze: %zu, roznych multizbiorow: %zu, sizeof(multiset): %zu\n",
+           size, groups, sizeof(multiset));
+    fflush(stdout);
+    countersOpen(&c, true);
+
+    reporterInit(&r, &opts, sink);
+    countersStart(&c);
+    findSimilarCold(text, size, &r);
+    reportFinish(&r);
+    countersStop(&c, "similarSets (zimne)");
+
+    reporterInit(&r, &opts, sink);
+    countersStart(&c);
+    findSimilar(text, size, &r);
+    reportFinish(&r);
+    countersStop(&c, "findSimilar (gorace)");
+
+    countersClose(&c);
+    freeOptions(&opts);
+    arenaDestroy(memory);
+    free(text);
+    close(sink);
+    return 0;
+}
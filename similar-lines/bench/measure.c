@@ -0,0 +1,61 @@
+/**
+ * Pomocniczy program mierzący czas działania i szczytowe zużycie pamięci
+ * innego programu, używany przez tryb wydajnościowy skryptu test.sh (gdy
+ * go brakuje, skrypt używa /usr/bin/time). Uruchamia program
+ * z odziedziczonym wejściem i wyjściem, czeka na niego funkcją wait4
+ * i zapisuje do pliku wynikowego czas rzeczywisty w sekundach oraz
+ * szczytowy RSS w kilobajtach. Zwraca kod wyjścia programu.
+ * Użycie: measure plik_wynikowy program [argumenty...]
+ * Autor: Michał Skwarek
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// Kod wyjścia, gdy nie udało się uruchomić lub zmierzyć programu
+#define MEASURE_ERROR 127
+
+int main(int argc, char *argv[]) {
+    struct timespec start, end;
+    struct rusage usage;
+    int status;
+    pid_t child;
+    FILE *result;
+
+    if (argc < 3) {
+        fprintf(stderr, "Uzycie: %s plik_wynikowy program [argumenty...]\n",
+                argv[0]);
+        return MEASURE_ERROR;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    child = fork();
+
+    if (child < 0)
+        return MEASURE_ERROR;
+
+    if (child == 0) {
+        execvp(argv[2], argv + 2);
+        _exit(MEASURE_ERROR);
+    }
+
+    if (wait4(child, &status, 0, &usage) < 0)
+        return MEASURE_ERROR;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if ((result = fopen(argv[1], "w")) == NULL)
+        return MEASURE_ERROR;
+
+    fprintf(result, "%.6f %ld\n", (end.tv_sec - start.tv_sec)
+            + (end.tv_nsec - start.tv_nsec) / 1e9, usage.ru_maxrss);
+    fclose(result);
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : MEASURE_ERROR;
+}
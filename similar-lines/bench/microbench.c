@@ -0,0 +1,348 @@
+/**
+ * Mikrobenchmark najczęściej wywoływanych funkcji modułów recognizer i parser.
+ * Dołącza pliki źródłowe modułów, aby mierzyć także ich funkcje statyczne.
+ * Każda funkcja przetwarza korpus realistycznych słów (liczby dziesiętne,
+ * ósemkowe, szesnastkowe, zmiennoprzecinkowe, nieskończoności, słowa
+ * powtarzające się w dziennikach, długie identyfikatory). Korpusy z różnymi
+ * słowami mierzą processWord przy chybieniach pamięci podręcznej słów,
+ * a korpusy inf i logi - przy trafieniach. Po rozgrzewce wykonywanych jest
+ * wiele pomiarów całego korpusu, a wynikiem jest mediana i medianowe
+ * odchylenie bezwzględne (MAD) liczby cykli procesora na jedno wywołanie.
+ * Użycie: microbench [liczba pomiarów] [liczba słów w korpusie]
+ * Autor: Michał Skwarek
+ */
+
+#include "../recognizer.c"
+#include "../parser.c"
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Domyślna liczba pomiarów każdej funkcji
+#define DEFAULT_SAMPLES 201
+
+// Liczba przebiegów rozgrzewających przed pomiarami
+#define WARMUP 20
+
+// Domyślna liczba słów w każdym korpusie
+#define DEFAULT_WORDS 4096
+
+// Maksymalna długość słowa w korpusie
+#define MAX_WORD 64
+
+/**
+ * Korpus słów jednego rodzaju.
+ * name - nazwa korpusu
+ * words - słowa zakończone znakiem '\0'
+ * sizes - długości słów
+ * count - liczba słów
+ */
+struct corpus {
+    const char *name;
+    char (*words)[MAX_WORD];
+    size_t *sizes;
+    size_t count;
+};
+typedef struct corpus corpus;
+
+// Wynik mierzonych funkcji, aby kompilator nie usunął wywołań
+static volatile size_t sink;
+
+/**
+ * Funkcja zwracająca bieżącą wartość licznika cykli procesora.
+ * Poza architekturą x86 korzysta z zegara monotonicznego (w nanosekundach).
+ */
+static uint64_t cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_lfence();
+    uint64_t t = __rdtsc();
+    _mm_lfence();
+    return t;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+/**
+ * Prosty generator liczb pseudolosowych (xorshift64), aby korpusy były
+ * identyczne w każdym uruchomieniu.
+ * state - stan generatora
+ */
+static uint64_t randomNext(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+ * Funkcja tworząca korpus słów danego rodzaju.
+ * name - nazwa korpusu
+ * kind - rodzaj słów
+ * count - liczba słów
+ */
+static corpus makeCorpus(const char *name, int kind, size_t count) {
+    static const char *infinities[] = {"inf", "+inf", "-inf"};
+    static const char letters[] = "abcdefghijklmnopqrstuvwxyz_-.:/";
+    // Słowa powtarzające się w dziennikach: poziomy, kody, nazwy hostów
+    static const char *logWords[] = {
+        "INFO", "WARN", "ERROR", "DEBUG", "200", "301", "404", "500",
+        "GET", "POST", "0.25", "1.5", "-1", "0x1F", "017", "ms",
+        "web-01.example.com", "web-02.example.com", "db-01.example.com",
+        "request", "response", "timeout", "user=42", "status"};
+    uint64_t state = 0x9e3779b97f4a7c15ULL + (uint64_t) kind;
+    corpus c = {name, malloc(count * MAX_WORD), malloc(count * sizeof(size_t)),
+                count};
+
+    if (c.words == NULL || c.sizes == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < count; i++) {
+        uint64_t r = randomNext(&state);
+
+        switch (kind) {
+            case 0:
+                snprintf(c.words[i], MAX_WORD, "%llu",
+                         (unsigned long long) (r % 100000000));
+                break;
+            case 1:
+                snprintf(c.words[i], MAX_WORD, "0%llo",
+                         (unsigned long long) (r % 1000000));
+                break;
+            case 2:
+                snprintf(c.words[i], MAX_WORD, "0x%llx",
+                         (unsigned long long) (r >> 16));
+                break;
+            case 3:
+                snprintf(c.words[i], MAX_WORD, "%s%llu.%llue%d",
+                         r & 1 ? "-" : "", (unsigned long long) (r % 1000),
+                         (unsigned long long) ((r >> 10) % 10000),
+                         (int) ((r >> 24) % 20) - 10);
+                break;
+            case 4:
+                snprintf(c.words[i], MAX_WORD, "%s", infinities[r % 3]);
+                break;
+            case 5:
+                snprintf(c.words[i], MAX_WORD, "-%llu",
+                         (unsigned long long) (r % 100000000 + 1));
+                break;
+            case 6:
+                snprintf(c.words[i], MAX_WORD, "%s",
+                         logWords[r % (sizeof(logWords)
+                                       / sizeof(logWords[0]))]);
+                break;
+            default: {
+                size_t length = 16 + r % (MAX_WORD - 17);
+                for (size_t j = 0; j < length; j++)
+                    c.words[i][j] = letters[randomNext(&state)
+                                            % (sizeof(letters) - 1)];
+                c.words[i][length] = '\0';
+            }
+        }
+
+        c.sizes[i] = strlen(c.words[i]);
+    }
+
+    return c;
+}
+
+/**
+ * Funkcja porównująca dwie liczby do qsort.
+ * a - pierwsza liczba
+ * b - druga liczba
+ */
+static int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Funkcja wypisująca medianę, MAD i minimum pomiarów.
+ * name - nazwa funkcji
+ * corpusName - nazwa korpusu
+ * samples - pomiary (liczba cykli na wywołanie), sortowane w miejscu
+ * count - liczba pomiarów
+ */
+static void report(const char *name, const char *corpusName,
+                   double *samples, size_t count) {
+    double *deviations = malloc(count * sizeof(double));
+    if (deviations == NULL)
+        exit(1);
+
+    qsort(samples, count, sizeof(double), compareDoubles);
+    double median = samples[count / 2];
+
+    for (size_t i = 0; i < count; i++)
+        deviations[i] = samples[i] > median ? samples[i] - median
+                                            : median - samples[i];
+
+    qsort(deviations, count, sizeof(double), compareDoubles);
+    printf("%-20s %-12s %10.2f %8.2f %10.2f\n", name, corpusName, median,
+           deviations[count / 2], samples[0]);
+    free(deviations);
+}
+
+/**
+ * Funkcja mierząca funkcję rozpoznającą na całym korpusie.
+ * name - nazwa funkcji
+ * recognize - funkcja rozpoznająca
+ * c - korpus
+ * samples - tablica na pomiary
+ * count - liczba pomiarów
+ */
+static void benchRecognizer(const char *name, bool (*recognize)(char *, size_t),
+                            corpus *c, double *samples, size_t count) {
+    for (size_t s = 0; s < WARMUP + count; s++) {
+        size_t hits = 0;
+        uint64_t start = cycles();
+
+        for (size_t i = 0; i < c->count; i++)
+            hits += recognize(c->words[i], c->sizes[i]);
+
+        uint64_t end = cycles();
+        sink += hits;
+
+        if (s >= WARMUP)
+            samples[s - WARMUP] = (double) (end - start) / c->count;
+    }
+
+    report(name, c->name, samples, count);
+}
+
+/**
+ * Funkcja mierząca processWord (rozpoznanie i konwersję) na całym korpusie.
+ * Każdy pomiar korzysta z nowej areny, tworzonej poza mierzonym czasem.
+ * c - korpus
+ * samples - tablica na pomiary
+ * count - liczba pomiarów
+ */
+static void benchProcessWord(corpus *c, double *samples, size_t count) {
+    multiset set;
+
+    for (size_t s = 0; s < WARMUP + count; s++) {
+        arena *memory = arenaCreate();
+        initializeMultiset(&set);
+        uint64_t start = cycles();
+
+        for (size_t i = 0; i < c->count; i++)
+            processWord(&set, c->words[i], c->sizes[i], memory);
+
+        uint64_t end = cycles();
+        sink += set.sizeUnsigInts + set.sizeNotNumbers;
+        arenaDestroy(memory);
+
+        if (s >= WARMUP)
+            samples[s - WARMUP] = (double) (end - start) / c->count;
+    }
+
+    report("processWord", c->name, samples, count);
+}
+
+/**
+ * Funkcja mierząca createMultiset na wierszach złożonych ze słów wszystkich
+ * korpusów. Wiersze są odtwarzane przed każdym pomiarem, bo createMultiset
+ * je modyfikuje.
+ * corpora - korpusy
+ * corpusCount - liczba korpusów
+ * samples - tablica na pomiary
+ * count - liczba pomiarów
+ */
+static void benchCreateMultiset(corpus *corpora, size_t corpusCount,
+                                double *samples, size_t count) {
+    size_t lines = corpora[0].count, size = 0;
+    size_t *offsets = malloc((lines + 1) * sizeof(size_t));
+    char *text = malloc(lines * corpusCount * MAX_WORD + 1);
+    char *work = malloc(lines * corpusCount * MAX_WORD + 1);
+    multiset set;
+
+    if (offsets == NULL || text == NULL || work == NULL)
+        exit(1);
+
+    // Wiersz i składa się z i-tego słowa każdego korpusu
+    for (size_t i = 0; i < lines; i++) {
+        offsets[i] = size;
+
+        for (size_t k = 0; k < corpusCount; k++) {
+            memcpy(text + size, corpora[k].words[i], corpora[k].sizes[i]);
+            size += corpora[k].sizes[i];
+            text[size++] = k + 1 < corpusCount ? ' ' : '\0';
+        }
+    }
+
+    for (size_t s = 0; s < WARMUP + count; s++) {
+        arena *memory = arenaCreate();
+        memcpy(work, text, size);
+        uint64_t start = cycles();
+
+        for (size_t i = 0; i < lines; i++) {
+            createMultiset(&set, work + offsets[i], i + 1, memory,
+                           processWord);
+            sink += set.sizeNotNumbers;
+        }
+
+        uint64_t end = cycles();
+        arenaDestroy(memory);
+
+        if (s >= WARMUP)
+            samples[s - WARMUP] = (double) (end - start) / lines;
+    }
+
+    report("createMultiset", "wiersze", samples, count);
+    free(offsets);
+    free(text);
+    free(work);
+}
+
+int main(int argc, char *argv[]) {
+    size_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : DEFAULT_SAMPLES;
+    size_t words = argc > 2 ? strtoull(argv[2], NULL, 10) : DEFAULT_WORDS;
+    const char *names[] = {"dziesietne", "osemkowe", "szesnastkowe",
+                           "zmiennoprz", "inf", "ujemne", "logi",
+                           "identyfik"};
+    size_t corpusCount = sizeof(names) / sizeof(names[0]);
+    corpus corpora[sizeof(names) / sizeof(names[0])];
+    double *samples = malloc(count * sizeof(double));
+
+    if (samples == NULL || count == 0 || words == 0)
+        exit(1);
+
+    for (size_t k = 0; k < corpusCount; k++)
+        corpora[k] = makeCorpus(names[k], (int) k, words);
+
+#if defined(__x86_64__) || defined(__i386__)
+    printf("jednostka: cykle (rdtsc) na wywolanie, pomiarow: %zu\n", count);
+#else
+    printf("jednostka: ns na wywolanie, pomiarow: %zu\n", count);
+#endif
+    printf("%-20s %-12s %10s %8s %10s\n", "funkcja", "korpus", "mediana",
+           "MAD", "minimum");
+
+    for (size_t k = 0; k < corpusCount; k++) {
+        benchRecognizer("recognizeAnyFloat", recognizeAnyFloat, &corpora[k],
+                        samples, count);
+        benchRecognizer("recognizeHex", recognizeHex, &corpora[k],
+                        samples, count);
+        benchRecognizer("recognizeOctal", recognizeOctal, &corpora[k],
+                        samples, count);
+        benchRecognizer("recognizeUnsigInt", recognizeUnsigInt, &corpora[k],
+                        samples, count);
+        benchProcessWord(&corpora[k], samples, count);
+    }
+
+    benchCreateMultiset(corpora, corpusCount, samples, count);
+
+    for (size_t k = 0; k < corpusCount; k++) {
+        free(corpora[k].words);
+        free(corpora[k].sizes);
+    }
+
+    free(samples);
+    return 0;
+}
@@ -0,0 +1,165 @@
+/**
+ * Benchmark czytnika wierszy wspólnego z kalkulatorem wielomianów.
+ * Zapisuje do pliku tymczasowego wiersze o zadanej długości i wielokrotnie
+ * przegląda cały plik na dwa sposoby - funkcją getline oraz funkcją
+ * readerNextLine. Dla każdego sposobu wypisuje medianę czasów pomiarów
+ * przeliczoną na przepustowość i czas na jeden wiersz.
+ * Użycie: reader_bench [liczba wierszy] [długość wiersza] [liczba pomiarów]
+ * Autor: Michał Skwarek
+ */
+
+#define _GNU_SOURCE
+
+#include "reader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+// Maksymalna liczba pomiarów każdego sposobu
+#define MAX_RUNS 64
+
+/**
+ * Funkcja zwracająca czas, jaki upłynął między dwoma chwilami (w sekundach).
+ * start - chwila początkowa
+ * end - chwila końcowa
+ */
+static double elapsed(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec)
+           + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Funkcja porównująca czasy pomiarów dla qsort.
+ */
+static int compareTimes(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Funkcja zapisująca do pliku tymczasowego wiersze o zadanej długości.
+ * Ostatni wiersz nie kończy się znakiem nowej linii.
+ * lines - liczba wierszy
+ * length - liczba znaków wiersza (bez znaku nowej linii)
+ */
+static FILE *prepareInput(size_t lines, size_t length) {
+    FILE *file = tmpfile();
+
+    if (file == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < lines; i++) {
+        for (size_t j = 0; j < length; j++)
+            fputc(j % 8 == 7 ? ' ' : 'a' + (char) ((i + j) % 26), file);
+
+        if (i + 1 < lines)
+            fputc('\n', file);
+    }
+
+    fflush(file);
+    return file;
+}
+
+/**
+ * Funkcja przeglądająca plik funkcją getline. Zwraca łączną długość
+ * wierszy bez znaków nowej linii, by kompilator nie pominął pętli.
+ * file - plik z wierszami
+ */
+static size_t scanGetline(FILE *file) {
+    char *line = NULL;
+    size_t buffSize = 0, total = 0;
+    ssize_t read;
+
+    rewind(file);
+
+    while ((read = getline(&line, &buffSize, file)) != -1)
+        total += line[read - 1] == '\n' ? (size_t) read - 1 : (size_t) read;
+
+    free(line);
+    return total;
+}
+
+/**
+ * Funkcja przeglądająca plik czytnikiem wierszy. Zwraca łączną długość
+ * wierszy, tak jak scanGetline.
+ * file - plik z wierszami
+ */
+static size_t scanReader(FILE *file) {
+    lineReader *reader;
+    lineView view;
+    size_t total = 0;
+
+    if (lseek(fileno(file), 0, SEEK_SET) < 0)
+        exit(1);
+
+    reader = readerCreate(fileno(file));
+
+    while (readerNextLine(reader, &view))
+        total += view.length;
+
+    readerDestroy(reader);
+    return total;
+}
+
+/**
+ * Funkcja mierząca wielokrotnie jeden sposób przeglądania pliku i
+ * wypisująca medianę pomiarów.
+ * name - nazwa sposobu
+ * scan - funkcja przeglądająca plik
+ * file - plik z wierszami
+ * bytes - rozmiar pliku
+ * lines - liczba wierszy
+ * runs - liczba pomiarów
+ */
+static size_t measure(const char *name, size_t (*scan)(FILE *), FILE *file,
+                      size_t bytes, size_t lines, size_t runs) {
+    double times[MAX_RUNS];
+    struct timespec start, end;
+    size_t total = scan(file);
+
+    for (size_t i = 0; i < runs; i++) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        scan(file);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        times[i] = elapsed(&start, &end);
+    }
+
+    qsort(times, runs, sizeof(double), compareTimes);
+    double median = times[runs / 2];
+
+    printf("%-14s mediana %.4f s, %8.1f MB/s, %6.1f ns/wiersz\n", name,
+           median, bytes / median / 1e6, median * 1e9 / lines);
+    return total;
+}
+
+int main(int argc, char *argv[]) {
+    size_t lines = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    size_t length = argc > 2 ? strtoull(argv[2], NULL, 10) : 40;
+    size_t runs = argc > 3 ? strtoull(argv[3], NULL, 10) : 9;
+
+    if (lines == 0 || runs == 0 || runs > MAX_RUNS) {
+        fprintf(stderr, "ERROR niepoprawne argumenty\n");
+        return 1;
+    }
+
+    FILE *file = prepareInput(lines, length);
+    size_t bytes = lines * (length + 1) - 1;
+
+    printf("wiersze: %zu, dlugosc wiersza: %zu, pomiary: %zu\n",
+           lines, length, runs);
+
+    size_t expected = measure("getline", scanGetline, file, bytes, lines,
+                              runs);
+    size_t total = measure("readerNextLine", scanReader, file, bytes, lines,
+                           runs);
+
+    // Oba sposoby muszą zobaczyć te same znaki
+    if (total != expected) {
+        fprintf(stderr, "ERROR rozne dlugosci: %zu i %zu\n", expected, total);
+        return 1;
+    }
+
+    fclose(file);
+    return 0;
+}
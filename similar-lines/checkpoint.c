@@ -0,0 +1,337 @@
+// Flaga potrzebna do poprawnego działania funkcji fsync, mkstemp, sigaction
+// i clock_gettime
+#define _GNU_SOURCE
+
+#include "checkpoint.h"
+#include "index.h"
+#include "multiset.h"
+#include "parser.h"
+#include "similar.h"
+#include "arena.h"
+#include "reader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Rozmiar bufora przy pomijaniu przetworzonych danych z potoku
+#define SKIP_BUFFER_SIZE (1 << 16)
+
+// Końcówka nazwy pliku tymczasowego, uzupełniana przez mkstemp
+#define TEMPORARY_SUFFIX ".XXXXXX"
+
+// Liczba pól tożsamości danych wejściowych: rozmiar i czas modyfikacji
+// (sekundy i nanosekundy)
+#define IDENTITY_FIELDS 3
+
+// Rozmiar zapisywany dla danych wejściowych, które nie są zwykłym plikiem
+#define UNKNOWN_SIZE UINT64_MAX
+
+// Plik tymczasowy zapisywanego właśnie punktu kontrolnego - usuwany przez
+// obsługę sygnałów, gdy program zostanie przerwany w trakcie zapisu
+static char *volatile pendingTemporary = NULL;
+
+/**
+ * Funkcja obsługi sygnałów kończących program. Usuwa niedokończony plik
+ * tymczasowy i ponownie zgłasza sygnał, który z domyślną obsługą kończy
+ * program tak jak bez tej funkcji.
+ * sig - numer sygnału
+ */
+static void onTerminate(int sig) {
+    char *temporary = pendingTemporary;
+
+    if (temporary != NULL)
+        unlink(temporary);
+
+    raise(sig);
+}
+
+/**
+ * Funkcja ustawiająca obsługę sygnałów kończących program. Obsługa jest
+ * jednorazowa - sygnał zgłoszony ponownie przez onTerminate kończy program.
+ */
+static void installHandlers(void) {
+    struct sigaction action = {0};
+
+    sigemptyset(&action.sa_mask);
+    action.sa_handler = onTerminate;
+    action.sa_flags = SA_RESETHAND;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    sigaction(SIGHUP, &action, NULL);
+}
+
+/**
+ * Funkcja ustalająca tożsamość danych wejściowych: rozmiar i czas modyfikacji
+ * zwykłego pliku. Dla potoku rozmiar wynosi UNKNOWN_SIZE, a czas 0 - wtedy
+ * zgodność sprawdza jedynie pominięcie przetworzonych danych.
+ * identity - miejsce na pola tożsamości
+ */
+static void inputIdentity(uint64_t identity[IDENTITY_FIELDS]) {
+    struct stat input;
+
+    if (fstat(STDIN_FILENO, &input) != 0 || !S_ISREG(input.st_mode)) {
+        identity[0] = UNKNOWN_SIZE;
+        identity[1] = identity[2] = 0;
+        return;
+    }
+
+    identity[0] = (uint64_t) input.st_size;
+    identity[1] = (uint64_t) input.st_mtim.tv_sec;
+    identity[2] = (uint64_t) input.st_mtim.tv_nsec;
+}
+
+/**
+ * Funkcja zapisująca punkt kontrolny: tożsamość danych wejściowych, miejsce
+ * w nich, numer następnego wiersza i wszystkie grupy indeksu
+ * z reprezentantami. Stan trafia najpierw do pliku tymczasowego o unikalnej
+ * nazwie (mkstemp w katalogu punktu kontrolnego), który po fsync zastępuje
+ * poprzedni punkt kontrolny funkcją rename - przerwanie programu w trakcie
+ * zapisu nie psuje ostatniego pełnego stanu, a równoległe wywołania nie
+ * nadpisują sobie plików tymczasowych. Plik zapisywany jest w reprezentacji
+ * bieżącej maszyny. Błąd zapisu nie przerywa pracy.
+ * path - ścieżka pliku punktu kontrolnego
+ * x - indeks grup
+ * p - parser
+ * rules - reguły rozpoznawania słów
+ * identity - tożsamość danych wejściowych
+ */
+static void saveCheckpoint(const char *path, groupIndex *x, parser *p,
+                           uint32_t rules,
+                           const uint64_t identity[IDENTITY_FIELDS]) {
+    char *temporary = malloc(strlen(path) + sizeof(TEMPORARY_SUFFIX));
+    uint32_t version = CHECKPOINT_VERSION;
+    uint64_t offset = (uint64_t) p->offset, count = p->count;
+    FILE *f = NULL;
+    bool ok;
+    int fd;
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (temporary == NULL)
+        exit(1);
+
+    strcpy(temporary, path);
+    strcat(temporary, TEMPORARY_SUFFIX);
+    fd = mkstemp(temporary);
+
+    if (fd >= 0) {
+        pendingTemporary = temporary;
+
+        if ((f = fdopen(fd, "wb")) == NULL)
+            close(fd);
+    }
+
+    ok = f != NULL;
+    ok = ok && writeBytes(f, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_SIZE)
+         && writeBytes(f, &version, sizeof(version))
+         && writeBytes(f, &rules, sizeof(rules))
+         && writeBytes(f, identity, IDENTITY_FIELDS * sizeof(uint64_t))
+         && writeBytes(f, &offset, sizeof(offset))
+         && writeBytes(f, &count, sizeof(count))
+         && indexSave(x, f);
+
+    if (f != NULL) {
+        ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+        ok = fclose(f) == 0 && ok;
+    }
+
+    ok = ok && rename(temporary, path) == 0;
+
+    if (!ok) {
+        if (fd >= 0)
+            unlink(temporary);
+
+        fprintf(stderr, "Nie udalo sie zapisac punktu kontrolnego %s\n",
+                path);
+    }
+
+    pendingTemporary = NULL;
+    free(temporary);
+}
+
+/**
+ * Funkcja odtwarzająca indeks i stan parsera z punktu kontrolnego.
+ * Zwraca 1 po odczytaniu stanu, 0, gdy pliku nie ma (praca zaczyna się od
+ * początku), i -1 dla uszkodzonego pliku lub stanu zapisanego przy innych
+ * regułach rozpoznawania słów.
+ * path - ścieżka pliku punktu kontrolnego
+ * x - pusty indeks grup
+ * p - parser
+ * rules - reguły rozpoznawania słów
+ * identity - miejsce na zapisaną tożsamość danych wejściowych
+ */
+static int loadCheckpoint(const char *path, groupIndex *x, parser *p,
+                          uint32_t rules, uint64_t identity[IDENTITY_FIELDS]) {
+    char magic[CHECKPOINT_MAGIC_SIZE];
+    uint32_t version, savedRules;
+    uint64_t offset, count;
+    bool ok;
+    FILE *f = fopen(path, "rb");
+
+    if (f == NULL)
+        return errno == ENOENT ? 0 : -1;
+
+    ok = readBytes(f, magic, CHECKPOINT_MAGIC_SIZE)
+         && memcmp(magic, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_SIZE) == 0
+         && readBytes(f, &version, sizeof(version))
+         && version == CHECKPOINT_VERSION
+         && readBytes(f, &savedRules, sizeof(savedRules))
+         && savedRules == rules
+         && readBytes(f, identity, IDENTITY_FIELDS * sizeof(uint64_t))
+         && readBytes(f, &offset, sizeof(offset))
+         && readBytes(f, &count, sizeof(count))
+         && indexLoad(x, f);
+
+    fclose(f);
+
+    if (!ok)
+        return -1;
+
+    p->offset = (off_t) offset;
+    p->count = count;
+    return 1;
+}
+
+/**
+ * Funkcja pomijająca dane wejściowe przetworzone przed punktem kontrolnym.
+ * Plik jest przewijany, a z potoku dane są czytane i odrzucane. Kończy
+ * program z błędem, gdy danych jest mniej niż przed zapisem stanu.
+ * offset - liczba bajtów do pominięcia
+ */
+static void skipInput(off_t offset) {
+    char *buffer;
+    ssize_t count;
+
+    if (offset == 0 || lseek(STDIN_FILENO, offset, SEEK_CUR) >= 0)
+        return;
+
+    buffer = malloc(SKIP_BUFFER_SIZE);
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (buffer == NULL)
+        exit(1);
+
+    while (offset > 0) {
+        count = read(STDIN_FILENO, buffer, offset < SKIP_BUFFER_SIZE
+                                           ? (size_t) offset
+                                           : SKIP_BUFFER_SIZE);
+
+        if (count < 0 && errno == EINTR)
+            continue;
+
+        if (count <= 0) {
+            fprintf(stderr, "Dane wejsciowe sa krotsze niz w punkcie "
+                            "kontrolnym\n");
+            exit(1);
+        }
+
+        offset -= count;
+    }
+
+    free(buffer);
+}
+
+/**
+ * Funkcja zwracająca liczbę sekund od zadanej chwili.
+ * since - chwila odczytana zegarem CLOCK_MONOTONIC
+ */
+static double secondsSince(const struct timespec *since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - since->tv_sec)
+           + (double) (now.tv_nsec - since->tv_nsec) / 1e9;
+}
+
+/**
+ * Funkcja wyszukująca podobne wiersze z okresowym zapisem stanu pracy.
+ * Wiersze są dodawane do indeksu grup na bieżąco, a punkt kontrolny jest
+ * zapisywany co opts->checkpointEvery wierszy i nie rzadziej niż co
+ * CHECKPOINT_SECONDS sekund (zegar sprawdzany jest co CHECKPOINT_CLOCK_LINES
+ * wierszy). Zapis kosztuje czas proporcjonalny do liczby różnych wierszy,
+ * więc przy domyślnych ustawieniach jest niewielką częścią pracy. Po dotarciu
+ * do końca danych zapisywany jest stan końcowy. Z opcją --resume praca
+ * zaczyna się od ostatniego zapisanego stanu - dane wejściowe muszą być
+ * wtedy tymi samymi danymi, podanymi od początku. Dla zwykłego pliku jego
+ * rozmiar i czas modyfikacji muszą być takie jak przy zapisie stanu - inne
+ * dane kończą program z błędem, zamiast wypisać nieaktualne grupy.
+ * opts - opcje programu
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ * r - moduł wypisujący grupy
+ * c - liczniki wydajności faz
+ */
+void runCheckpointed(const options *opts, wordProcessor process,
+                     reporter *r, counters *c) {
+    groupIndex *x = indexCreate();
+    uint32_t rules = optionsRules(opts);
+    uint64_t identity[IDENTITY_FIELDS], saved[IDENTITY_FIELDS];
+    size_t sinceSave = 0;
+    struct timespec lastSave;
+    lineReader *reader;
+    arenaMark mark;
+    multiset set;
+    parser p;
+
+    parserInit(&p, NULL, x->memory, process, true);
+    inputIdentity(identity);
+    installHandlers();
+
+    if (opts->resume) {
+        countersStart(c);
+        switch (loadCheckpoint(opts->checkpoint, x, &p, rules, saved)) {
+            case -1:
+                fprintf(stderr, "Bledny punkt kontrolny %s\n",
+                        opts->checkpoint);
+                exit(1);
+            case 1:
+                if (memcmp(saved, identity, sizeof(identity)) != 0) {
+                    fprintf(stderr, "Dane wejsciowe roznia sie od danych "
+                                    "z punktu kontrolnego\n");
+                    exit(1);
+                }
+        }
+
+        skipInput(p.offset);
+        countersStop(c, "resume");
+    }
+
+    // Sortowanie każdego wiersza odbywa się zaraz po jego parsowaniu
+    countersStart(c);
+    reader = readerCreate(STDIN_FILENO);
+    p.reader = reader;
+    clock_gettime(CLOCK_MONOTONIC, &lastSave);
+
+    while (true) {
+        mark = arenaGetMark(x->memory);
+
+        if (!parseLine(&p, &set))
+            break;
+
+        sortMultiset(&set);
+        indexAdd(x, &set, mark);
+        ++sinceSave;
+
+        if ((opts->checkpointEvery > 0 && sinceSave >= opts->checkpointEvery)
+            || (sinceSave % CHECKPOINT_CLOCK_LINES == 0
+                && secondsSince(&lastSave) >= CHECKPOINT_SECONDS)) {
+            saveCheckpoint(opts->checkpoint, x, &p, rules, identity);
+            sinceSave = 0;
+            clock_gettime(CLOCK_MONOTONIC, &lastSave);
+        }
+    }
+
+    readerDestroy(reader);
+
+    saveCheckpoint(opts->checkpoint, x, &p, rules, identity);
+    countersStop(c, "loadInput+sort");
+
+    countersStart(c);
+    indexReport(x, r);
+    countersStop(c, "report");
+    indexDestroy(x);
+}
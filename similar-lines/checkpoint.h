@@ -0,0 +1,24 @@
+#include "options.h"
+#include "report.h"
+#include "recognizer.h"
+#include "counters.h"
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// Nagłówek pliku punktu kontrolnego: sygnatura i wersja
+#define CHECKPOINT_MAGIC "SLCP"
+#define CHECKPOINT_MAGIC_SIZE 4
+#define CHECKPOINT_VERSION 3
+
+// Maksymalny czas między kolejnymi punktami kontrolnymi (w sekundach)
+#define CHECKPOINT_SECONDS 60
+
+// Co ile wierszy sprawdzany jest czas od ostatniego punktu kontrolnego
+#define CHECKPOINT_CLOCK_LINES 1024
+
+// Funkcja wyszukująca podobne wiersze z okresowym zapisem stanu pracy
+extern void runCheckpointed(const options *opts, wordProcessor process,
+                            reporter *r, counters *c);
+
+#endif //CHECKPOINT_H
@@ -0,0 +1,152 @@
+// Flaga potrzebna do poprawnego działania funkcji malloc_usable_size
+#define _GNU_SOURCE
+
+#include "compact.h"
+#include "multiset.h"
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdalign.h>
+#include <malloc.h>
+
+/**
+ * Funkcja zwracająca rozmiar bloku z tablicami jednego multizbioru: kolejno
+ * liczb zmiennoprzecinkowych, całkowitych, wskaźników na "nieliczby" oraz
+ * znaków "nieliczb". Tablice mieszczące się w multizbiorze nie zajmują
+ * miejsca w bloku, ale znaki "nieliczb" są w nim zawsze.
+ * set - multizbiór
+ */
+static size_t blockSize(multiset *set) {
+    char **words = notNumbersOf(set);
+    size_t size = 0;
+
+    if (set->sizeAnyFloats > INLINE_FLOATS)
+        size += set->sizeAnyFloats * sizeof(long double);
+    if (set->sizeUnsigInts > INLINE_INTS)
+        size += set->sizeUnsigInts * sizeof(unsigned long long);
+    if (set->sizeSigInts > INLINE_INTS)
+        size += set->sizeSigInts * sizeof(long long);
+    if (set->sizeNotNumbers > INLINE_WORDS)
+        size += set->sizeNotNumbers * sizeof(char *);
+
+    for (uint32_t i = 0; i < set->sizeNotNumbers; i++)
+        size += strlen(words[i]) + 1;
+
+    return size;
+}
+
+/**
+ * Funkcja kopiująca tablicę słów z areny do bloku i przesuwająca wskaźnik
+ * na wolne miejsce w bloku.
+ * heap - miejsce wskaźnika na tablicę w unii multizbioru
+ * typeSize - rozmiar słowa
+ * count - liczba słów
+ * next - wolne miejsce w bloku
+ */
+static void moveArray(void *heap, size_t typeSize, size_t count, char **next) {
+    void *x;
+
+    // Wskaźnik heap jest odczytywany i zapisywany przez memcpy, bo w unii
+    // ma typ zależny od przechowywanych słów
+    memcpy(&x, heap, sizeof(void *));
+    memcpy(*next, x, count * typeSize);
+    memcpy(heap, next, sizeof(void *));
+    *next += count * typeSize;
+}
+
+/**
+ * Funkcja przenosząca wszystkie tablice i słowa multizbioru do jednego,
+ * ciasno wypełnionego bloku w nowej arenie.
+ * set - multizbiór
+ * memory - nowa arena
+ */
+static void compactMultiset(multiset *set, arena *memory) {
+    size_t size = blockSize(set), length;
+    char *next, **words;
+
+    if (size == 0)
+        return;
+
+    next = arenaAlloc(memory, size, alignof(long double));
+
+    // Kolejność tablic według wyrównania - bez przerw między nimi
+    if (set->sizeAnyFloats > INLINE_FLOATS)
+        moveArray(&set->anyFloats, sizeof(long double), set->sizeAnyFloats,
+                  &next);
+    if (set->sizeUnsigInts > INLINE_INTS)
+        moveArray(&set->unsigInts, sizeof(unsigned long long),
+                  set->sizeUnsigInts, &next);
+    if (set->sizeSigInts > INLINE_INTS)
+        moveArray(&set->sigInts, sizeof(long long), set->sizeSigInts, &next);
+    if (set->sizeNotNumbers > INLINE_WORDS)
+        moveArray(&set->notNumbers, sizeof(char *), set->sizeNotNumbers,
+                  &next);
+
+    words = notNumbersOf(set);
+
+    for (uint32_t i = 0; i < set->sizeNotNumbers; i++) {
+        length = strlen(words[i]) + 1;
+        memcpy(next, words[i], length);
+        words[i] = next;
+        next += length;
+    }
+}
+
+/**
+ * Funkcja kompaktująca pamięć po parsowaniu. Tablice słów rosną przez
+ * podwajanie, a powiększane tablice zostawiają w arenie swoje stare kopie,
+ * więc po parsowaniu duża część areny jest nieużywana. Funkcja przenosi
+ * słowa każdego multizbioru do jednego bloku dokładnego rozmiaru w nowej
+ * arenie, oddaje systemowi starą arenę i przycina tablicę multizbiorów.
+ * W trakcie kopiowania obie areny istnieją jednocześnie.
+ * text - tablica multizbiorów
+ * size - liczba multizbiorów
+ * memory - arena ze słowami, zastępowana nową areną
+ * stats - miejsce na statystyki
+ */
+multiset *compactAll(multiset *text, size_t size, arena **memory,
+                     compactStats *stats) {
+    arena *compacted = arenaCreate();
+    arenaStats before = arenaGetStats(*memory), after;
+
+    stats->textBefore = malloc_usable_size(text);
+
+    for (size_t i = 0; i < size; i++)
+        compactMultiset(&text[i], compacted);
+
+    arenaDestroy(*memory);
+    *memory = compacted;
+
+    text = realloc(text, (size > 0 ? size : 1) * sizeof(multiset));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (text == NULL)
+        exit(1);
+
+    after = arenaGetStats(compacted);
+    stats->usedBefore = before.used;
+    stats->usedAfter = after.used;
+    stats->reservedBefore = before.reserved;
+    stats->reservedAfter = after.reserved;
+    stats->textAfter = malloc_usable_size(text);
+    return text;
+}
+
+/**
+ * Funkcja wypisująca statystyki kompaktowania na wyjście diagnostyczne.
+ * stats - statystyki
+ */
+void printCompactStats(const compactStats *stats) {
+    size_t before = stats->reservedBefore + stats->textBefore;
+    size_t after = stats->reservedAfter + stats->textAfter;
+
+    fprintf(stderr, "STATS arena: zajete %zu B -> %zu B, "
+                    "zarezerwowane %zu B -> %zu B\n",
+            stats->usedBefore, stats->usedAfter,
+            stats->reservedBefore, stats->reservedAfter);
+    fprintf(stderr, "STATS tablica multizbiorow: %zu B -> %zu B\n",
+            stats->textBefore, stats->textAfter);
+    fprintf(stderr, "STATS odzyskano: %zu B\n",
+            before > after ? before - after : 0);
+}
@@ -0,0 +1,29 @@
+#include "multiset.h"
+#include "arena.h"
+#include <stddef.h>
+
+#ifndef COMPACT_H
+#define COMPACT_H
+
+/**
+ * Statystyki kompaktowania pamięci multizbiorów.
+ * usedBefore, usedAfter - bajty zajęte przez przydziały areny
+ * reservedBefore, reservedAfter - bajty bloków areny pobranych z systemu
+ * textBefore, textAfter - bajty przydzielone tablicy multizbiorów
+ */
+struct compactStats {
+    size_t usedBefore, usedAfter;
+    size_t reservedBefore, reservedAfter;
+    size_t textBefore, textAfter;
+};
+typedef struct compactStats compactStats;
+
+// Funkcja przenosząca słowa wszystkich multizbiorów do nowej, ciasno
+// wypełnionej areny i przycinająca tablicę multizbiorów
+extern multiset *compactAll(multiset *text, size_t size, arena **memory,
+                            compactStats *stats);
+
+// Funkcja wypisująca statystyki kompaktowania na stderr
+extern void printCompactStats(const compactStats *stats);
+
+#endif //COMPACT_H
@@ -0,0 +1,167 @@
+// Flaga potrzebna do poprawnego działania funkcji syscall
+#define _GNU_SOURCE
+
+#include "counters.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/**
+ * Opis licznika - nazwa wypisywana w wynikach, typ i konfiguracja zdarzenia.
+ */
+struct counterEvent {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+};
+
+// Zdarzenia w kolejności zgodnej z enum counterKind
+static const struct counterEvent events[COUNTER_KINDS] = {
+    {"cykle", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instrukcje", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"chybienia L1d", PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+     | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {"chybienia LLC", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"zle przewidziane skoki", PERF_TYPE_HARDWARE,
+     PERF_COUNT_HW_BRANCH_MISSES}
+};
+
+/**
+ * Funkcja otwierająca pojedynczy licznik dla bieżącego procesu.
+ * Licznik obejmuje też wątki utworzone później (np. wątek czytnika)
+ * i jest początkowo wyłączony. Zwraca deskryptor lub -1.
+ * event - opis licznika
+ */
+static int openEvent(const struct counterEvent *event) {
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event->type;
+    attr.config = event->config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+                       | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/**
+ * Funkcja otwierająca liczniki.
+ * Gdy żaden licznik nie jest dostępny, wypisuje jednokrotnie ostrzeżenie -
+ * wtedy mierzony jest tylko czas rzeczywisty faz.
+ * c - liczniki
+ * enabled - czy profilowanie jest włączone
+ */
+void countersOpen(counters *c, bool enabled) {
+    int available = 0, error = 0;
+
+    c->enabled = enabled;
+
+    for (int i = 0; i < COUNTER_KINDS; i++) {
+        c->fd[i] = enabled ? openEvent(&events[i]) : -1;
+        c->values[i] = 0;
+
+        if (c->fd[i] >= 0)
+            ++available;
+        else if (error == 0)
+            error = errno;
+    }
+
+    if (enabled && available == 0) {
+        fprintf(stderr, "PROFILE liczniki sprzetowe niedostepne (%s), "
+                        "mierzony jest tylko czas\n", strerror(error));
+    }
+}
+
+/**
+ * Funkcja zerująca i uruchamiająca liczniki na początku fazy.
+ * c - liczniki
+ */
+void countersStart(counters *c) {
+    if (!c->enabled)
+        return;
+
+    for (int i = 0; i < COUNTER_KINDS; i++) {
+        if (c->fd[i] >= 0) {
+            ioctl(c->fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(c->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &c->start);
+}
+
+/**
+ * Funkcja odczytująca wartość licznika.
+ * Jeśli jądro dzieliło licznik z innymi (multipleksowanie), wartość jest
+ * przeskalowana do pełnego czasu działania licznika.
+ * fd - deskryptor licznika
+ */
+static uint64_t readCounter(int fd) {
+    // Wartość, czas włączenia i czas faktycznego liczenia
+    uint64_t data[3];
+
+    if (read(fd, data, sizeof(data)) != sizeof(data) || data[2] == 0)
+        return 0;
+
+    if (data[2] < data[1])
+        return (uint64_t) ((double) data[0] * data[1] / data[2]);
+
+    return data[0];
+}
+
+/**
+ * Funkcja zatrzymująca liczniki i wypisująca wyniki fazy na stderr.
+ * c - liczniki
+ * phase - nazwa fazy
+ */
+void countersStop(counters *c, const char *phase) {
+    struct timespec end;
+
+    if (!c->enabled)
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    c->seconds = (end.tv_sec - c->start.tv_sec)
+                 + (end.tv_nsec - c->start.tv_nsec) / 1e9;
+
+    fprintf(stderr, "PROFILE %s: czas %.6f s", phase, c->seconds);
+
+    for (int i = 0; i < COUNTER_KINDS; i++) {
+        if (c->fd[i] < 0)
+            continue;
+
+        ioctl(c->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+        c->values[i] = readCounter(c->fd[i]);
+        fprintf(stderr, ", %s %llu", events[i].name,
+                (unsigned long long) c->values[i]);
+    }
+
+    if (c->fd[COUNTER_CYCLES] >= 0 && c->fd[COUNTER_INSTRUCTIONS] >= 0
+        && c->values[COUNTER_CYCLES] > 0) {
+        fprintf(stderr, ", IPC %.2f", (double) c->values[COUNTER_INSTRUCTIONS]
+                                      / c->values[COUNTER_CYCLES]);
+    }
+
+    fprintf(stderr, "\n");
+}
+
+/**
+ * Funkcja zamykająca otwarte liczniki.
+ * c - liczniki
+ */
+void countersClose(counters *c) {
+    for (int i = 0; i < COUNTER_KINDS; i++) {
+        if (c->fd[i] >= 0)
+            close(c->fd[i]);
+    }
+}
@@ -0,0 +1,51 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+/**
+ * Mierzone sprzętowe liczniki wydajności.
+ */
+enum counterKind {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_L1D_MISSES,
+    COUNTER_LLC_MISSES,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_KINDS
+};
+
+/**
+ * Zestaw liczników wydajności otwartych przez perf_event_open.
+ * Liczniki, których nie udało się otworzyć (np. w kontenerze), są pomijane,
+ * a czas rzeczywisty fazy jest mierzony zawsze.
+ * enabled - czy profilowanie jest włączone
+ * fd - deskryptory liczników (-1 dla niedostępnych)
+ * values - wartości liczników z ostatniej fazy
+ * start - początek ostatniej fazy
+ * seconds - czas rzeczywisty ostatniej fazy
+ */
+struct counters {
+    bool enabled;
+    int fd[COUNTER_KINDS];
+    uint64_t values[COUNTER_KINDS];
+    struct timespec start;
+    double seconds;
+};
+typedef struct counters counters;
+
+// Funkcja otwierająca liczniki, jeśli profilowanie jest włączone
+extern void countersOpen(counters *c, bool enabled);
+
+// Funkcja zerująca i uruchamiająca liczniki na początku fazy
+extern void countersStart(counters *c);
+
+// Funkcja zatrzymująca liczniki i wypisująca wyniki fazy na stderr
+extern void countersStop(counters *c, const char *phase);
+
+// Funkcja zamykająca liczniki
+extern void countersClose(counters *c);
+
+#endif //COUNTERS_H
@@ -0,0 +1,57 @@
+/**
+ * Narzędzie odczytujące grupy podobnych wierszy zapisane przez similar_lines
+ * w formacie binarnym i wypisujące je w formacie tekstowym lub JSON Lines.
+ * Pozwala sprawdzić, że oba formaty niosą te same dane, np.:
+ *   similar_lines --format binary < dane | similar_decode
+ * daje to samo, co samo similar_lines < dane.
+ * Użycie: similar_decode [--format text|jsonl] < dane
+ * Autor: Michał Skwarek
+ */
+
+#include "encoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Kod wyjścia w przypadku niepoprawnych danych lub argumentów
+#define DECODE_ERROR 1
+
+/**
+ * Funkcja kończąca program z komunikatem o błędzie.
+ * message - komunikat
+ */
+static void fail(const char *message) {
+    fprintf(stderr, "similar_decode: %s\n", message);
+    exit(DECODE_ERROR);
+}
+
+int main(int argc, char *argv[]) {
+    format form = FORMAT_TEXT;
+    decoder in;
+    encoder out;
+    int status;
+
+    if (argc == 3 && strcmp(argv[1], "--format") == 0
+        && strcmp(argv[2], "jsonl") == 0)
+        form = FORMAT_JSONL;
+    else if (argc != 1 && !(argc == 3 && strcmp(argv[1], "--format") == 0
+                            && strcmp(argv[2], "text") == 0))
+        fail("uzycie: similar_decode [--format text|jsonl] < dane");
+
+    if (!decoderInit(&in, stdin))
+        fail("nieznany format danych");
+
+    encoderInit(&out, STDOUT_FILENO, form, in.digest);
+
+    while ((status = decodeGroup(&in)) == 1)
+        encodeGroup(&out, in.lines, in.size, in.groupDigest);
+
+    encoderFinish(&out);
+    decoderFinish(&in);
+
+    if (status < 0)
+        fail("bledne lub niekompletne dane");
+
+    return 0;
+}
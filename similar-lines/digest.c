@@ -0,0 +1,143 @@
+#include "digest.h"
+#include "multiset.h"
+#include <math.h>
+
+// Stałe mieszające funkcji splitmix64
+#define MIX_1 0xbf58476d1ce4e5b9ULL
+#define MIX_2 0x94d049bb133111ebULL
+
+// Stałe funkcji skrótu FNV-1a dla "nieliczb"
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+// Mnożnik łączący kolejne składowe skrótu (złoty podział)
+#define COMBINE 0x9e3779b97f4a7c15ULL
+
+/**
+ * Funkcja mieszająca bity liczby 64-bitowej (splitmix64).
+ * x - liczba do wymieszania
+ */
+static uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= MIX_1;
+    x ^= x >> 27;
+    x *= MIX_2;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * Funkcja dołączająca kolejną składową do skrótu.
+ * Wynik zależy od kolejności składowych.
+ * h - dotychczasowy skrót
+ * x - składowa
+ */
+static uint64_t combine(uint64_t h, uint64_t x) {
+    return (h ^ mix(x)) * COMBINE + (h >> 29);
+}
+
+/**
+ * Funkcja dołączająca kolejną składową do skrótu, dla innych modułów.
+ * h - dotychczasowy skrót
+ * x - składowa
+ */
+uint64_t digestCombine(uint64_t h, uint64_t x) {
+    return combine(h, x);
+}
+
+/**
+ * Funkcja zamieniająca liczbę zmiennoprzecinkową na liczbę 64-bitową.
+ * Nie korzysta z reprezentacji bitowej, bo long double może zawierać
+ * nieokreślone bajty wyrównania.
+ * x - liczba
+ */
+static uint64_t floatBits(long double x) {
+    int exponent;
+    long double mantissa;
+
+    if (isinf(x))
+        return x > 0 ? 1 : 2;
+
+    // Mantysa z przedziału [0.5, 1) po przemnożeniu przez 2^64 jest całkowita
+    mantissa = frexpl(fabsl(x), &exponent);
+    return combine((uint64_t) (ldexpl(mantissa, 64)),
+                   ((uint64_t) (unsigned) exponent << 1) | (x < 0));
+}
+
+/**
+ * Funkcja obliczająca skrót słowa.
+ * word - słowo zakończone znakiem '\0'
+ */
+static uint64_t wordBits(const char *word) {
+    uint64_t h = FNV_OFFSET;
+
+    while (*word != '\0') {
+        h ^= (unsigned char) *word++;
+        h *= FNV_PRIME;
+    }
+
+    return h;
+}
+
+/**
+ * Funkcje obliczające skrót liczby zmiennoprzecinkowej i słowa, dla innych
+ * modułów. Równe liczby (także 0 i -0) mają równe skróty.
+ * x - liczba
+ * word - słowo zakończone znakiem '\0'
+ */
+uint64_t digestFloat(long double x) {
+    return floatBits(x);
+}
+
+uint64_t digestWord(const char *word) {
+    return wordBits(word);
+}
+
+/**
+ * Funkcja obliczająca 64-bitowy skrót multizbioru.
+ * Multizbiór musi być posortowany - wtedy podobne multizbiory mają równe
+ * skróty. Równość skrótów nie przesądza jednak o podobieństwie.
+ * x - posortowany multizbiór
+ */
+uint64_t multisetDigest(multiset *x) {
+    unsigned long long *unsigInts = unsigIntsOf(x);
+    long long *sigInts = sigIntsOf(x);
+    long double *anyFloats = anyFloatsOf(x);
+    char **notNumbers = notNumbersOf(x);
+    uint64_t h = 0;
+
+    h = combine(h, x->sizeUnsigInts);
+    h = combine(h, x->sizeSigInts);
+    h = combine(h, x->sizeAnyFloats);
+    h = combine(h, x->sizeNotNumbers);
+
+    for (uint32_t i = 0; i < x->sizeUnsigInts; i++)
+        h = combine(h, unsigInts[i]);
+    for (uint32_t i = 0; i < x->sizeSigInts; i++)
+        h = combine(h, (uint64_t) sigInts[i]);
+    for (uint32_t i = 0; i < x->sizeAnyFloats; i++)
+        h = combine(h, floatBits(anyFloats[i]));
+    for (uint32_t i = 0; i < x->sizeNotNumbers; i++)
+        h = combine(h, wordBits(notNumbers[i]));
+
+    return mix(h);
+}
+
+/**
+ * Funkcja obliczająca skrót części multizbioru porównywanej dokładnie także
+ * w trybie tolerancji: "nieliczb" i łącznej liczby liczb, bez ich wartości.
+ * x - posortowany multizbiór
+ */
+uint64_t multisetDigestWords(multiset *x) {
+    char **notNumbers = notNumbersOf(x);
+    uint64_t h = 0;
+
+    h = combine(h, (uint64_t) x->sizeUnsigInts + x->sizeSigInts
+                   + x->sizeAnyFloats);
+    h = combine(h, x->sizeNotNumbers);
+
+    for (uint32_t i = 0; i < x->sizeNotNumbers; i++)
+        h = combine(h, wordBits(notNumbers[i]));
+
+    return mix(h);
+}
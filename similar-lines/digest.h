@@ -0,0 +1,21 @@
+#include "multiset.h"
+#include <stdint.h>
+
+#ifndef DIGEST_H
+#define DIGEST_H
+
+// Funkcja obliczająca 64-bitowy skrót posortowanego multizbioru
+extern uint64_t multisetDigest(multiset *x);
+
+// Funkcja obliczająca skrót "nieliczb" posortowanego multizbioru i liczby
+// jego liczb, bez ich wartości
+extern uint64_t multisetDigestWords(multiset *x);
+
+// Funkcja dołączająca kolejną składową do skrótu
+extern uint64_t digestCombine(uint64_t h, uint64_t x);
+
+// Funkcje obliczające skrót liczby zmiennoprzecinkowej i słowa
+extern uint64_t digestFloat(long double x);
+extern uint64_t digestWord(const char *word);
+
+#endif //DIGEST_H
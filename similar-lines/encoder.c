@@ -0,0 +1,336 @@
+// Flaga potrzebna do poprawnego działania funkcji write
+#define _GNU_SOURCE
+
+#include "encoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+// Maksymalna liczba bajtów jednej liczby zapisanej tekstowo lub jako varint
+#define MAX_NUMBER_SIZE 24
+
+// Liczba bajtów skrótu w formacie binarnym
+#define DIGEST_SIZE 8
+
+// Liczba bitów danych w jednym bajcie liczby varint
+#define VARINT_BITS 7
+
+/**
+ * Funkcja zapisująca zawartość bufora do deskryptora.
+ * Błąd zapisu kończy program, tak jak brak pamięci.
+ * e - koder
+ */
+static void flush(encoder *e) {
+    size_t done = 0;
+    ssize_t written;
+
+    while (done < e->used) {
+        written = write(e->fd, e->buffer + done, e->used - done);
+
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            exit(1);
+
+        done += (size_t) written;
+    }
+
+    e->used = 0;
+}
+
+/**
+ * Funkcja upewniająca się, że w buforze zmieści się size bajtów.
+ * e - koder
+ * size - liczba bajtów
+ */
+static void reserve(encoder *e, size_t size) {
+    if (e->used + size > ENCODER_BUFFER_SIZE)
+        flush(e);
+}
+
+/**
+ * Funkcja dopisująca bajty do bufora.
+ * e - koder
+ * data - bajty
+ * size - liczba bajtów, nie większa od rozmiaru bufora
+ */
+static void putBytes(encoder *e, const void *data, size_t size) {
+    reserve(e, size);
+    memcpy(e->buffer + e->used, data, size);
+    e->used += size;
+}
+
+/**
+ * Funkcja dopisująca liczbę w zapisie dziesiętnym.
+ * e - koder
+ * x - liczba
+ */
+static void putDecimal(encoder *e, unsigned long long x) {
+    char digits[MAX_NUMBER_SIZE];
+    size_t i = MAX_NUMBER_SIZE;
+
+    do {
+        digits[--i] = (char) ('0' + x % 10);
+        x /= 10;
+    } while (x > 0);
+
+    putBytes(e, digits + i, MAX_NUMBER_SIZE - i);
+}
+
+/**
+ * Funkcja dopisująca liczbę jako varint - po 7 bitów na bajt, od najmniej
+ * znaczących, z najstarszym bitem ustawionym we wszystkich bajtach
+ * poza ostatnim.
+ * e - koder
+ * x - liczba
+ */
+static void putVarint(encoder *e, unsigned long long x) {
+    reserve(e, MAX_NUMBER_SIZE);
+
+    while (x >= 0x80) {
+        e->buffer[e->used++] = (char) ((x & 0x7f) | 0x80);
+        x >>= 7;
+    }
+
+    e->buffer[e->used++] = (char) x;
+}
+
+/**
+ * Funkcja przygotowująca koder.
+ * W formacie binarnym od razu zapisuje nagłówek.
+ * e - koder
+ * fd - deskryptor, do którego zapisywane są dane
+ * form - format danych
+ * digest - czy wypisywać skróty grup
+ */
+void encoderInit(encoder *e, int fd, format form, bool digest) {
+    e->fd = fd;
+    e->form = form;
+    e->digest = digest && form != FORMAT_TEXT;
+    e->used = 0;
+    e->buffer = malloc(ENCODER_BUFFER_SIZE);
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (e->buffer == NULL)
+        exit(1);
+
+    if (form == FORMAT_BINARY) {
+        char header[BINARY_MAGIC_SIZE + 2] = BINARY_MAGIC;
+        header[BINARY_MAGIC_SIZE] = BINARY_VERSION;
+        header[BINARY_MAGIC_SIZE + 1] = e->digest ? BINARY_FLAG_DIGEST : 0;
+        putBytes(e, header, sizeof(header));
+    }
+}
+
+/**
+ * Funkcja kodująca grupę w formacie binarnym.
+ * e - koder
+ * lines - rosnące numery wierszy
+ * size - liczba wierszy
+ * digest - skrót grupy
+ */
+static void encodeBinary(encoder *e, const size_t *lines, size_t size,
+                         uint64_t digest) {
+    unsigned char bytes[DIGEST_SIZE];
+
+    putVarint(e, size);
+    putVarint(e, lines[0]);
+
+    for (size_t i = 1; i < size; i++)
+        putVarint(e, lines[i] - lines[i - 1]);
+
+    if (e->digest) {
+        for (int i = 0; i < DIGEST_SIZE; i++)
+            bytes[i] = (unsigned char) (digest >> (8 * i));
+
+        putBytes(e, bytes, DIGEST_SIZE);
+    }
+}
+
+/**
+ * Funkcja kodująca grupę w formacie JSON Lines.
+ * e - koder
+ * lines - rosnące numery wierszy
+ * size - liczba wierszy
+ * digest - skrót grupy
+ */
+static void encodeJson(encoder *e, const size_t *lines, size_t size,
+                       uint64_t digest) {
+    char hex[2 * DIGEST_SIZE + 1];
+
+    putBytes(e, "{\"lines\":[", 10);
+
+    for (size_t i = 0; i < size; i++) {
+        if (i > 0)
+            putBytes(e, ",", 1);
+
+        putDecimal(e, lines[i]);
+    }
+
+    putBytes(e, "]", 1);
+
+    if (e->digest) {
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) digest);
+        putBytes(e, ",\"digest\":\"", 11);
+        putBytes(e, hex, 2 * DIGEST_SIZE);
+        putBytes(e, "\"", 1);
+    }
+
+    putBytes(e, "}\n", 2);
+}
+
+/**
+ * Funkcja kodująca grupę podobnych wierszy w wybranym formacie.
+ * e - koder
+ * lines - rosnące numery wierszy
+ * size - liczba wierszy, co najmniej 1
+ * digest - skrót grupy, używany tylko, gdy koder wypisuje skróty
+ */
+void encodeGroup(encoder *e, const size_t *lines, size_t size,
+                 uint64_t digest) {
+    if (e->form == FORMAT_BINARY) {
+        encodeBinary(e, lines, size, digest);
+    }
+    else if (e->form == FORMAT_JSONL) {
+        encodeJson(e, lines, size, digest);
+    }
+    else {
+        putDecimal(e, lines[0]);
+
+        for (size_t i = 1; i < size; i++) {
+            putBytes(e, " ", 1);
+            putDecimal(e, lines[i]);
+        }
+
+        putBytes(e, "\n", 1);
+    }
+}
+
+/**
+ * Funkcja kończąca strumień (w formacie binarnym grupą o rozmiarze 0),
+ * zapisująca resztę bufora i zwalniająca go.
+ * e - koder
+ */
+void encoderFinish(encoder *e) {
+    if (e->form == FORMAT_BINARY)
+        putVarint(e, 0);
+
+    flush(e);
+    free(e->buffer);
+}
+
+/**
+ * Funkcja przygotowująca dekoder i odczytująca nagłówek strumienia.
+ * Zwraca fałsz, gdy strumień nie zaczyna się poprawnym nagłówkiem.
+ * d - dekoder
+ * input - strumień z danymi w formacie binarnym
+ */
+bool decoderInit(decoder *d, FILE *input) {
+    char header[BINARY_MAGIC_SIZE + 2];
+
+    d->input = input;
+    d->lines = NULL;
+    d->size = 0;
+    d->groupDigest = 0;
+    d->maxSize = 0;
+
+    if (fread(header, 1, sizeof(header), input) != sizeof(header)
+        || memcmp(header, BINARY_MAGIC, BINARY_MAGIC_SIZE) != 0
+        || header[BINARY_MAGIC_SIZE] != BINARY_VERSION)
+        return false;
+
+    d->digest = header[BINARY_MAGIC_SIZE + 1] & BINARY_FLAG_DIGEST;
+    return true;
+}
+
+/**
+ * Funkcja odczytująca liczbę zapisaną jako varint.
+ * Zwraca fałsz przy niekompletnych lub błędnych danych - także wtedy, gdy
+ * dziesiąty bajt niesie bity powyżej 64.
+ * input - strumień z danymi
+ * x - miejsce na liczbę
+ */
+static bool getVarint(FILE *input, unsigned long long *x) {
+    int c, shift = 0;
+
+    *x = 0;
+
+    do {
+        if ((c = getc(input)) == EOF || shift >= 64
+            || (shift == 63 && (c & 0x7f) > 1))
+            return false;
+
+        *x |= (unsigned long long) (c & 0x7f) << shift;
+        shift += VARINT_BITS;
+    } while (c & 0x80);
+
+    return true;
+}
+
+/**
+ * Funkcja odczytująca kolejną grupę do pól lines, size i groupDigest.
+ * Numery wierszy są zapisane jako dodatnie różnice kolejnych numerów (pierwszy
+ * względem 0), więc różnica 0 albo suma przekraczająca zakres size_t oznacza
+ * błędne dane. Zwraca 1 po odczytaniu grupy, 0 na końcu strumienia i -1 przy
+ * błędnych lub niekompletnych danych.
+ * d - dekoder
+ */
+int decodeGroup(decoder *d) {
+    unsigned char bytes[DIGEST_SIZE];
+    unsigned long long x, line;
+
+    if (!getVarint(d->input, &x))
+        return -1;
+    if (x == 0)
+        return 0;
+
+    // Tablica nie może mieć więcej elementów, niż da się zaadresować
+    if (x > SIZE_MAX / (2 * sizeof(size_t)))
+        return -1;
+
+    // Rozmiar grupy pochodzi z danych, więc tablica rośnie dopiero wraz
+    // z odczytanymi numerami wierszy - ucięty strumień kończy się błędem
+    d->size = 0;
+
+    while (d->size < x) {
+        if (!getVarint(d->input, &line) || line == 0
+            || (d->size > 0 && line > SIZE_MAX - d->lines[d->size - 1])
+            || line > SIZE_MAX)
+            return -1;
+
+        if (d->size == d->maxSize) {
+            d->maxSize = 1 + 2 * d->maxSize;
+            d->lines = realloc(d->lines, d->maxSize * sizeof(size_t));
+
+            // Awaryjne wyjście z programu w przypadku braku pamięci
+            if (d->lines == NULL)
+                exit(1);
+        }
+
+        d->lines[d->size] = d->size == 0 ? line
+                                         : d->lines[d->size - 1] + line;
+        d->size++;
+    }
+
+    d->groupDigest = 0;
+
+    if (d->digest) {
+        if (fread(bytes, 1, DIGEST_SIZE, d->input) != DIGEST_SIZE)
+            return -1;
+
+        for (int i = 0; i < DIGEST_SIZE; i++)
+            d->groupDigest |= (uint64_t) bytes[i] << (8 * i);
+    }
+
+    return 1;
+}
+
+/**
+ * Funkcja zwalniająca pamięć dekodera.
+ * d - dekoder
+ */
+void decoderFinish(decoder *d) {
+    free(d->lines);
+}
@@ -0,0 +1,89 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef ENCODER_H
+#define ENCODER_H
+
+// Rozmiar bufora, który jest zapisywany jednym wywołaniem write
+#define ENCODER_BUFFER_SIZE (1 << 20)
+
+// Nagłówek formatu binarnego: sygnatura, wersja i flagi
+#define BINARY_MAGIC "SLGR"
+#define BINARY_MAGIC_SIZE 4
+#define BINARY_VERSION 1
+#define BINARY_FLAG_DIGEST 1
+
+/**
+ * Formaty wypisywania grup podobnych wierszy.
+ * FORMAT_TEXT - numery wierszy oddzielone spacjami, grupa w wierszu
+ * FORMAT_BINARY - nagłówek, a po nim dla każdej grupy jej rozmiar, pierwszy
+ *                 wiersz i różnice kolejnych wierszy zapisane jako varint
+ *                 (LEB128), opcjonalnie 8-bajtowy skrót (little endian);
+ *                 strumień kończy grupa o rozmiarze 0
+ * FORMAT_JSONL - jeden obiekt JSON na grupę: {"lines":[...],"digest":"..."}
+ */
+enum format {
+    FORMAT_TEXT,
+    FORMAT_BINARY,
+    FORMAT_JSONL
+};
+typedef enum format format;
+
+/**
+ * Strumieniowy koder grup, zbierający dane w dużym buforze.
+ * fd - deskryptor, do którego zapisywane są dane
+ * form - format danych
+ * digest - czy wypisywać skróty grup (poza formatem tekstowym)
+ * buffer - bufor danych czekających na zapis
+ * used - liczba bajtów w buforze
+ */
+struct encoder {
+    int fd;
+    format form;
+    bool digest;
+    char *buffer;
+    size_t used;
+};
+typedef struct encoder encoder;
+
+/**
+ * Strumieniowy dekoder grup zapisanych w formacie binarnym.
+ * input - strumień z danymi
+ * digest - czy grupy w strumieniu mają skróty
+ * lines - numery wierszy ostatnio odczytanej grupy
+ * size - liczba wierszy ostatnio odczytanej grupy
+ * groupDigest - skrót ostatnio odczytanej grupy (0, gdy brak skrótów)
+ * maxSize - pamięć przydzielona tablicy lines
+ */
+struct decoder {
+    FILE *input;
+    bool digest;
+    size_t *lines;
+    size_t size;
+    uint64_t groupDigest;
+    size_t maxSize;
+};
+typedef struct decoder decoder;
+
+// Funkcja przygotowująca koder i zapisująca ewentualny nagłówek
+extern void encoderInit(encoder *e, int fd, format form, bool digest);
+
+// Funkcja kodująca grupę o rosnących numerach wierszy
+extern void encodeGroup(encoder *e, const size_t *lines, size_t size,
+                        uint64_t digest);
+
+// Funkcja kończąca strumień, zapisująca resztę bufora i zwalniająca go
+extern void encoderFinish(encoder *e);
+
+// Funkcja odczytująca nagłówek strumienia, zwraca fałsz dla złych danych
+extern bool decoderInit(decoder *d, FILE *input);
+
+// Funkcja odczytująca kolejną grupę: 1 - grupa, 0 - koniec, -1 - błąd
+extern int decodeGroup(decoder *d);
+
+// Funkcja zwalniająca pamięć dekodera
+extern void decoderFinish(decoder *d);
+
+#endif //ENCODER_H
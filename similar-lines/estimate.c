@@ -0,0 +1,187 @@
+#include "estimate.h"
+#include "parser.h"
+#include "reader.h"
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+/**
+ * Funkcja przygotowująca pusty szkic.
+ * h - szkic
+ */
+void hllInit(hyperLogLog *h) {
+    memset(h->registers, 0, sizeof(h->registers));
+    h->lines = 0;
+}
+
+/**
+ * Funkcja dodająca skrót do szkicu. Skróty multizbiorów są już dobrze
+ * wymieszane, więc nie trzeba ich ponownie haszować.
+ * h - szkic
+ * digest - skrót multizbioru
+ */
+void hllAdd(hyperLogLog *h, uint64_t digest) {
+    size_t index = (size_t) (digest >> (64 - HLL_PRECISION));
+    uint64_t rest = digest << HLL_PRECISION;
+    // Pozycja pierwszej jedynki, ograniczona, gdy pozostałe bity są zerami
+    uint8_t rank = rest == 0 ? 64 - HLL_PRECISION + 1
+                             : (uint8_t) __builtin_clzll(rest) + 1;
+
+    if (rank > h->registers[index])
+        h->registers[index] = rank;
+
+    ++h->lines;
+}
+
+/**
+ * Funkcja dołączająca do szkicu inny szkic - wynik jest taki, jakby do
+ * jednego szkicu dodano skróty z obu.
+ * h - szkic
+ * other - dołączany szkic
+ */
+void hllMerge(hyperLogLog *h, const hyperLogLog *other) {
+    for (size_t i = 0; i < HLL_REGISTERS; i++) {
+        if (other->registers[i] > h->registers[i])
+            h->registers[i] = other->registers[i];
+    }
+
+    h->lines += other->lines;
+}
+
+/**
+ * Funkcja szacująca liczbę różnych skrótów dodanych do szkicu. Dla małych
+ * liczb, gdy część rejestrów jest pusta, korzysta z liczenia liniowego.
+ * Błąd standardowy oszacowania to około 1.04 / sqrt(HLL_REGISTERS).
+ * h - szkic
+ */
+double hllEstimate(const hyperLogLog *h) {
+    double m = HLL_REGISTERS, sum = 0, estimate;
+    double alpha = 0.7213 / (1 + 1.079 / m);
+    size_t zeros = 0;
+
+    for (size_t i = 0; i < HLL_REGISTERS; i++) {
+        sum += ldexp(1, -h->registers[i]);
+
+        if (h->registers[i] == 0)
+            ++zeros;
+    }
+
+    estimate = alpha * m * m / sum;
+
+    if (estimate <= 2.5 * m && zeros > 0)
+        estimate = m * log(m / (double) zeros);
+
+    return estimate;
+}
+
+/**
+ * Funkcja zapisująca szkic do pliku: nagłówek, precyzja, liczba wierszy
+ * (little endian) i rejestry.
+ * h - szkic
+ * path - ścieżka pliku
+ */
+bool hllSave(const hyperLogLog *h, const char *path) {
+    unsigned char header[SKETCH_MAGIC_SIZE + 2 + 8];
+    FILE *f = fopen(path, "wb");
+    bool ok;
+
+    if (f == NULL)
+        return false;
+
+    memcpy(header, SKETCH_MAGIC, SKETCH_MAGIC_SIZE);
+    header[SKETCH_MAGIC_SIZE] = SKETCH_VERSION;
+    header[SKETCH_MAGIC_SIZE + 1] = HLL_PRECISION;
+
+    for (int i = 0; i < 8; i++)
+        header[SKETCH_MAGIC_SIZE + 2 + i] = (unsigned char) (h->lines >> 8 * i);
+
+    ok = fwrite(header, 1, sizeof(header), f) == sizeof(header)
+         && fwrite(h->registers, 1, HLL_REGISTERS, f) == HLL_REGISTERS;
+
+    return fclose(f) == 0 && ok;
+}
+
+/**
+ * Funkcja odczytująca szkic zapisany przez hllSave. Szkice o innej
+ * precyzji nie mogą być łączone, więc są traktowane jak błędne.
+ * h - miejsce na szkic
+ * path - ścieżka pliku
+ */
+bool hllLoad(hyperLogLog *h, const char *path) {
+    unsigned char header[SKETCH_MAGIC_SIZE + 2 + 8];
+    FILE *f = fopen(path, "rb");
+    bool ok;
+
+    if (f == NULL)
+        return false;
+
+    ok = fread(header, 1, sizeof(header), f) == sizeof(header)
+         && memcmp(header, SKETCH_MAGIC, SKETCH_MAGIC_SIZE) == 0
+         && header[SKETCH_MAGIC_SIZE] == SKETCH_VERSION
+         && header[SKETCH_MAGIC_SIZE + 1] == HLL_PRECISION
+         && fread(h->registers, 1, HLL_REGISTERS, f) == HLL_REGISTERS;
+
+    h->lines = 0;
+
+    for (int i = 0; i < 8; i++)
+        h->lines |= (uint64_t) header[SKETCH_MAGIC_SIZE + 2 + i] << 8 * i;
+
+    fclose(f);
+    return ok;
+}
+
+/**
+ * Funkcja szacująca liczbę różnych multizbiorów w danych wejściowych.
+ * Dane są czytane raz, a pamięć każdego wiersza jest zwalniana zaraz po
+ * obliczeniu skrótu, więc poza buforami czytnika program zajmuje tylko
+ * szkic. Do wyniku dołączane są szkice z opcji --merge-sketch, a wynik
+ * można zapisać opcją --save-sketch, by połączyć go później z innymi.
+ * Wypisuje liczbę wierszy, oszacowanie liczby różnych multizbiorów
+ * i stopień duplikacji (część wierszy powtarzających wcześniejsze).
+ * opts - opcje programu
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ */
+void runEstimate(const options *opts, wordProcessor process) {
+    arena *memory = arenaCreate();
+    lineReader *reader = readerCreate(STDIN_FILENO);
+    hyperLogLog h, other;
+    uint64_t digest;
+    size_t number;
+    double distinct;
+    parser p;
+
+    hllInit(&h);
+    parserInit(&p, reader, memory, process, true);
+
+    while (parseDigest(&p, &digest, &number))
+        hllAdd(&h, digest);
+
+    readerDestroy(reader);
+    arenaDestroy(memory);
+
+    for (size_t i = 0; i < opts->sketchCount; i++) {
+        if (!hllLoad(&other, opts->sketches[i])) {
+            fprintf(stderr, "Bledny szkic %s\n", opts->sketches[i]);
+            exit(1);
+        }
+
+        hllMerge(&h, &other);
+    }
+
+    if (opts->saveSketch != NULL && !hllSave(&h, opts->saveSketch)) {
+        fprintf(stderr, "Nie udalo sie zapisac szkicu %s\n", opts->saveSketch);
+        exit(1);
+    }
+
+    // Oszacowanie nie może przekroczyć liczby wierszy
+    distinct = h.lines > 0 ? fmin(hllEstimate(&h), (double) h.lines) : 0;
+
+    printf("wiersze: %llu\n", (unsigned long long) h.lines);
+    printf("rozne multizbiory: %.0f (blad standardowy %.1f%%)\n", distinct,
+           104.0 / sqrt(HLL_REGISTERS));
+    printf("duplikacja: %.1f%%\n",
+           h.lines > 0 ? 100.0 * (1 - distinct / (double) h.lines) : 0.0);
+}
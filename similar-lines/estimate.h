@@ -0,0 +1,54 @@
+#include "options.h"
+#include "recognizer.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef ESTIMATE_H
+#define ESTIMATE_H
+
+// Liczba bitów skrótu wybierających rejestr szkicu
+#define HLL_PRECISION 12
+
+// Liczba rejestrów szkicu (4 KiB pamięci)
+#define HLL_REGISTERS (1 << HLL_PRECISION)
+
+// Nagłówek pliku ze szkicem: sygnatura i wersja
+#define SKETCH_MAGIC "SLHL"
+#define SKETCH_MAGIC_SIZE 4
+#define SKETCH_VERSION 1
+
+/**
+ * Szkic HyperLogLog szacujący liczbę różnych multizbiorów.
+ * Rejestr wybrany przez pierwsze HLL_PRECISION bitów skrótu pamięta
+ * największą pozycję pierwszej jedynki w pozostałych bitach.
+ * registers - rejestry szkicu
+ * lines - liczba wierszy dodanych do szkicu
+ */
+struct hyperLogLog {
+    uint8_t registers[HLL_REGISTERS];
+    uint64_t lines;
+};
+typedef struct hyperLogLog hyperLogLog;
+
+// Funkcja przygotowująca pusty szkic
+extern void hllInit(hyperLogLog *h);
+
+// Funkcja dodająca skrót multizbioru do szkicu
+extern void hllAdd(hyperLogLog *h, uint64_t digest);
+
+// Funkcja dołączająca do szkicu inny szkic
+extern void hllMerge(hyperLogLog *h, const hyperLogLog *other);
+
+// Funkcja szacująca liczbę różnych skrótów dodanych do szkicu
+extern double hllEstimate(const hyperLogLog *h);
+
+// Funkcja zapisująca szkic do pliku, zwraca fałsz w przypadku błędu
+extern bool hllSave(const hyperLogLog *h, const char *path);
+
+// Funkcja odczytująca szkic z pliku, zwraca fałsz w przypadku błędu
+extern bool hllLoad(hyperLogLog *h, const char *path);
+
+// Funkcja szacująca liczbę różnych wierszy i stopień duplikacji danych
+extern void runEstimate(const options *opts, wordProcessor process);
+
+#endif //ESTIMATE_H
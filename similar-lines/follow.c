@@ -0,0 +1,182 @@
+// Flaga potrzebna do poprawnego działania funkcji sigaction i nanosleep
+#define _GNU_SOURCE
+
+#include "follow.h"
+#include "index.h"
+#include "multiset.h"
+#include "parser.h"
+#include "similar.h"
+#include "report.h"
+#include "arena.h"
+#include "reader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Flagi ustawiane przez obsługę sygnałów: prośba o wypisanie grup
+// (SIGUSR1) i o zakończenie śledzenia (SIGINT, SIGTERM)
+static volatile sig_atomic_t emitRequested = 0;
+static volatile sig_atomic_t stopRequested = 0;
+
+/**
+ * Funkcje obsługi sygnałów - jedynie ustawiają flagi sprawdzane w pętli.
+ * sig - numer sygnału
+ */
+static void onEmit(int sig) {
+    (void) sig;
+    emitRequested = 1;
+}
+
+static void onStop(int sig) {
+    (void) sig;
+    stopRequested = 1;
+}
+
+/**
+ * Funkcja ustawiająca obsługę sygnałów trybu śledzenia.
+ */
+static void installHandlers(void) {
+    struct sigaction action = {0};
+
+    sigemptyset(&action.sa_mask);
+    action.sa_handler = onEmit;
+    sigaction(SIGUSR1, &action, NULL);
+    action.sa_handler = onStop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+}
+
+/**
+ * Funkcja wypisująca wszystkie obecne grupy jako osobny strumień w wybranym
+ * formacie. W formacie tekstowym kolejne zrzuty oddziela pusty wiersz.
+ * x - indeks grup
+ * opts - opcje programu
+ */
+static void emitSnapshot(groupIndex *x, const options *opts) {
+    reporter r;
+
+    reporterInit(&r, opts, STDOUT_FILENO);
+    indexReport(x, &r);
+    reportFinish(&r);
+
+    if (opts->form == FORMAT_TEXT && write(STDOUT_FILENO, "\n", 1) != 1)
+        exit(1);
+}
+
+/**
+ * Funkcja wypisująca zmianę wywołaną dodaniem wiersza: "N G" oznacza, że
+ * wiersz N dołączył do grupy, której pierwszym wierszem jest G. Grupy
+ * mniejsze niż minGroup nie są widoczne - gdy grupa osiąga ten rozmiar,
+ * wypisywane są wszystkie jej dotychczasowe wiersze.
+ * x - indeks grup
+ * number - numer grupy, do której trafił wiersz
+ * minGroup - minimalna liczba wierszy wypisywanej grupy
+ */
+static void emitChange(groupIndex *x, size_t number, size_t minGroup) {
+    indexGroup *g = &x->groups[number];
+    size_t first = g->size == minGroup ? 0 : g->size - 1;
+
+    if (g->size < minGroup)
+        return;
+
+    for (size_t i = first; i < g->size; i++)
+        printf("%zu %zu\n", g->lines[i], g->lines[0]);
+}
+
+/**
+ * Funkcja wypisująca wynik według trybu: zebrane zmiany albo pełny zrzut.
+ * x - indeks grup
+ * opts - opcje programu
+ */
+static void emit(groupIndex *x, const options *opts) {
+    if (opts->followChanges) {
+        if (fflush(stdout) != 0)
+            exit(1);
+    }
+    else {
+        emitSnapshot(x, opts);
+    }
+}
+
+/**
+ * Funkcja sprawdzająca, czy minął czas na kolejne wypisanie grup.
+ * last - chwila ostatniego wypisania (CLOCK_MONOTONIC)
+ * interval - czas między wypisaniami w sekundach (0 - tylko na sygnał)
+ */
+static bool intervalPassed(const struct timespec *last, size_t interval) {
+    struct timespec now;
+
+    if (interval == 0)
+        return false;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (size_t) (now.tv_sec - last->tv_sec) >= interval;
+}
+
+/**
+ * Funkcja grupująca na bieżąco wiersze dopisywane do pliku, jak tail -f.
+ * Każdy nowy wiersz trafia do indeksu grup w czasie niezależnym od liczby
+ * wcześniejszych wierszy. Grupy (albo zmiany) są wypisywane co
+ * opts->followInterval sekund, po otrzymaniu SIGUSR1 oraz na końcu pracy,
+ * którą kończy SIGINT lub SIGTERM. Niedokończony ostatni wiersz pliku czeka
+ * na znak nowej linii.
+ * opts - opcje programu
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ */
+void runFollow(const options *opts, wordProcessor process) {
+    struct timespec lastEmit, pause = {0, FOLLOW_IDLE_NS};
+    int fd = open(opts->follow, O_RDONLY);
+    groupIndex *x;
+    lineReader *reader;
+    arenaMark mark;
+    multiset set;
+    size_t number, sinceCheck = 0;
+    parser p;
+
+    if (fd < 0) {
+        fprintf(stderr, "Nie mozna otworzyc pliku %s\n", opts->follow);
+        exit(1);
+    }
+
+    installHandlers();
+    x = indexCreate();
+    reader = readerCreateFollowing(fd);
+    parserInit(&p, reader, x->memory, process, true);
+    clock_gettime(CLOCK_MONOTONIC, &lastEmit);
+
+    while (!stopRequested) {
+        mark = arenaGetMark(x->memory);
+
+        if (parseLine(&p, &set)) {
+            sortMultiset(&set);
+            number = indexAdd(x, &set, mark);
+
+            if (opts->followChanges)
+                emitChange(x, number, opts->minGroup);
+
+            // Przy ciągłym napływie wierszy zegar sprawdzany jest rzadko
+            if (++sinceCheck < FOLLOW_CLOCK_LINES && !emitRequested)
+                continue;
+        }
+        else {
+            nanosleep(&pause, NULL);
+        }
+
+        sinceCheck = 0;
+
+        if (emitRequested || intervalPassed(&lastEmit, opts->followInterval)) {
+            emitRequested = 0;
+            emit(x, opts);
+            clock_gettime(CLOCK_MONOTONIC, &lastEmit);
+        }
+    }
+
+    emit(x, opts);
+    readerDestroy(reader);
+    close(fd);
+    indexDestroy(x);
+}
@@ -0,0 +1,16 @@
+#include "options.h"
+#include "recognizer.h"
+
+#ifndef FOLLOW_H
+#define FOLLOW_H
+
+// Czas uśpienia, gdy w śledzonym pliku nie ma nowych wierszy (w nanosekundach)
+#define FOLLOW_IDLE_NS 20000000
+
+// Co ile wierszy sprawdzany jest czas od ostatniego wypisania grup
+#define FOLLOW_CLOCK_LINES 1024
+
+// Funkcja grupująca na bieżąco wiersze dopisywane do pliku opts->follow
+extern void runFollow(const options *opts, wordProcessor process);
+
+#endif //FOLLOW_H
@@ -0,0 +1,240 @@
+#include "heavy.h"
+#include "parser.h"
+#include "reader.h"
+#include "arena.h"
+#include "slots.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+/**
+ * Funkcja przygotowująca podsumowanie. Tablica haszująca ma co najmniej
+ * dwa razy więcej miejsc niż liczników.
+ * s - podsumowanie
+ * k - liczba liczników (co najwyżej HEAVY_MAX_COUNTERS)
+ */
+void spaceSavingInit(spaceSaving *s, size_t k) {
+    s->heap = malloc(k * sizeof(heavyCounter));
+    s->size = 0;
+    s->k = k;
+    s->capacity = 1;
+
+    while (s->capacity < 2 * k)
+        s->capacity *= 2;
+
+    s->slots = calloc(s->capacity, sizeof(size_t));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (s->heap == NULL || s->slots == NULL)
+        exit(1);
+}
+
+/**
+ * Funkcja zamieniająca miejscami dwa liczniki kopca, z poprawieniem
+ * wskazań tablicy haszującej.
+ * s - podsumowanie
+ * i, j - numery liczników
+ */
+static void swapCounters(spaceSaving *s, size_t i, size_t j) {
+    heavyCounter tmp = s->heap[i];
+    s->heap[i] = s->heap[j];
+    s->heap[j] = tmp;
+    s->slots[s->heap[i].slot] = i + 1;
+    s->slots[s->heap[j].slot] = j + 1;
+}
+
+/**
+ * Funkcje przywracające własność kopca od zadanego licznika w dół i w górę.
+ * s - podsumowanie
+ * i - numer licznika
+ */
+static void siftDown(spaceSaving *s, size_t i) {
+    size_t smallest, left, right;
+
+    while (true) {
+        smallest = i;
+        left = 2 * i + 1;
+        right = 2 * i + 2;
+
+        if (left < s->size && s->heap[left].count < s->heap[smallest].count)
+            smallest = left;
+        if (right < s->size && s->heap[right].count < s->heap[smallest].count)
+            smallest = right;
+
+        if (smallest == i)
+            return;
+
+        swapCounters(s, i, smallest);
+        i = smallest;
+    }
+}
+
+static void siftUp(spaceSaving *s, size_t i) {
+    while (i > 0 && s->heap[i].count < s->heap[(i - 1) / 2].count) {
+        swapCounters(s, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+/**
+ * Funkcja szukająca skrótu w tablicy haszującej. Zwraca miejsce skrótu
+ * albo pierwsze wolne miejsce.
+ * s - podsumowanie
+ * digest - skrót
+ */
+static size_t findSlot(spaceSaving *s, uint64_t digest) {
+    size_t i = slotHome(digest, s->capacity);
+
+    while (s->slots[i] != 0 && s->heap[s->slots[i] - 1].digest != digest)
+        i = slotNext(i, s->capacity);
+
+    return i;
+}
+
+/**
+ * Funkcja podająca skrót licznika z miejsca tablicy haszującej.
+ * table - podsumowanie
+ * slot - miejsce
+ * digest - miejsce na skrót
+ */
+static bool counterDigest(const void *table, size_t slot, uint64_t *digest) {
+    const spaceSaving *s = table;
+
+    if (s->slots[slot] == 0)
+        return false;
+
+    *digest = s->heap[s->slots[slot] - 1].digest;
+    return true;
+}
+
+/**
+ * Funkcja przenosząca licznik między miejscami tablicy haszującej,
+ * z aktualizacją miejsca zapamiętanego w kopcu.
+ * table - podsumowanie
+ * to - miejsce docelowe
+ * from - miejsce źródłowe
+ */
+static void moveCounter(void *table, size_t to, size_t from) {
+    spaceSaving *s = table;
+
+    s->slots[to] = s->slots[from];
+    s->heap[s->slots[to] - 1].slot = to;
+}
+
+/**
+ * Funkcja usuwająca miejsce z tablicy haszującej.
+ * s - podsumowanie
+ * i - usuwane miejsce
+ */
+static void removeSlot(spaceSaving *s, size_t i) {
+    i = slotRemove(s, s->capacity, i, counterDigest, moveCounter);
+    s->slots[i] = 0;
+}
+
+/**
+ * Funkcja licząca kolejne wystąpienie skrótu. Skrót z licznikiem zwiększa
+ * jego liczbę, a nowy skrót dostaje wolny licznik albo zastępuje licznik
+ * o najmniejszej liczbie m, przyjmując liczbę m + 1 i błąd m.
+ * s - podsumowanie
+ * digest - skrót multizbioru
+ * line - numer wiersza
+ */
+void spaceSavingAdd(spaceSaving *s, uint64_t digest, size_t line) {
+    size_t slot = findSlot(s, digest), i;
+    uint64_t minimum;
+
+    if (s->slots[slot] != 0) {
+        i = s->slots[slot] - 1;
+        ++s->heap[i].count;
+        siftDown(s, i);
+        return;
+    }
+
+    if (s->size < s->k) {
+        i = s->size++;
+        s->heap[i].count = 1;
+        s->heap[i].error = 0;
+    }
+    else {
+        i = 0;
+        minimum = s->heap[0].count;
+        removeSlot(s, s->heap[0].slot);
+        slot = findSlot(s, digest);
+        s->heap[i].count = minimum + 1;
+        s->heap[i].error = minimum;
+    }
+
+    s->heap[i].digest = digest;
+    s->heap[i].line = line;
+    s->heap[i].slot = slot;
+    s->slots[slot] = i + 1;
+
+    if (i == 0)
+        siftDown(s, i);
+    else
+        siftUp(s, i);
+}
+
+/**
+ * Funkcja zwalniająca pamięć podsumowania.
+ * s - podsumowanie
+ */
+void spaceSavingFree(spaceSaving *s) {
+    free(s->heap);
+    free(s->slots);
+}
+
+/**
+ * Funkcja porównująca liczniki do qsort - najpierw większe liczby,
+ * a przy równych wcześniejszy reprezentant.
+ * a - pierwszy licznik
+ * b - drugi licznik
+ */
+static int compareCounters(const void *a, const void *b) {
+    const heavyCounter *x = a;
+    const heavyCounter *y = b;
+
+    if (x->count != y->count)
+        return x->count > y->count ? -1 : 1;
+    else if (x->line != y->line)
+        return x->line < y->line ? -1 : 1;
+
+    return 0;
+}
+
+/**
+ * Funkcja wypisująca w przybliżeniu K najczęstszych grup wierszy w danych
+ * wejściowych, które nie muszą mieścić się w pamięci. Grupy są rozróżniane
+ * po skrócie posortowanego multizbioru. Dla każdej grupy wypisuje wiersz
+ * "L N E": reprezentanta L, oszacowanie liczby wierszy N i błąd E - grupa
+ * ma od N - E do N wierszy. Grupy są wypisywane od najliczniejszych.
+ * opts - opcje programu
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ */
+void runHeavyHitters(const options *opts, wordProcessor process) {
+    arena *memory = arenaCreate();
+    lineReader *reader = readerCreate(STDIN_FILENO);
+    uint64_t digest;
+    size_t number;
+    spaceSaving s;
+    parser p;
+
+    spaceSavingInit(&s, opts->heavyHitters);
+    parserInit(&p, reader, memory, process, true);
+
+    while (parseDigest(&p, &digest, &number))
+        spaceSavingAdd(&s, digest, number);
+
+    readerDestroy(reader);
+    arenaDestroy(memory);
+
+    qsort(s.heap, s.size, sizeof(heavyCounter), compareCounters);
+
+    for (size_t i = 0; i < s.size; i++)
+        printf("%zu %llu %llu\n", s.heap[i].line,
+               (unsigned long long) s.heap[i].count,
+               (unsigned long long) s.heap[i].error);
+
+    spaceSavingFree(&s);
+}
@@ -0,0 +1,63 @@
+#include "options.h"
+#include "recognizer.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef HEAVY_H
+#define HEAVY_H
+
+/**
+ * Licznik algorytmu Space-Saving dla jednego skrótu multizbioru.
+ * Prawdziwa liczba wystąpień leży w przedziale [count - error, count].
+ * digest - skrót multizbioru
+ * count - oszacowanie liczby wystąpień z góry
+ * error - największe możliwe zawyżenie oszacowania
+ * line - pierwszy wiersz policzony przez licznik (reprezentant)
+ * slot - miejsce licznika w tablicy haszującej
+ */
+struct heavyCounter {
+    uint64_t digest;
+    uint64_t count;
+    uint64_t error;
+    size_t line;
+    size_t slot;
+};
+typedef struct heavyCounter heavyCounter;
+
+// Największa liczba liczników, przy której rozmiary kopca i tablicy
+// haszującej (potęgi dwójki nie mniejszej niż 2k) mieszczą się w size_t
+#define HEAVY_MAX_COUNTERS (SIZE_MAX / 4 / sizeof(heavyCounter))
+
+/**
+ * Podsumowanie Space-Saving: k liczników w kopcu, którego korzeniem jest
+ * licznik o najmniejszej liczbie, i tablica haszująca skrót -> licznik.
+ * Nowy skrót przy pełnym podsumowaniu zastępuje najmniejszy licznik,
+ * dziedzicząc jego liczbę jako błąd. Pamięć zależy tylko od k.
+ * heap - kopiec liczników
+ * size - liczba liczników w kopcu
+ * k - największa liczba liczników
+ * slots - tablica haszująca: numer licznika w kopcu zwiększony o 1
+ * capacity - liczba miejsc tablicy haszującej (potęga dwójki)
+ */
+struct spaceSaving {
+    heavyCounter *heap;
+    size_t size;
+    size_t k;
+    size_t *slots;
+    size_t capacity;
+};
+typedef struct spaceSaving spaceSaving;
+
+// Funkcja przygotowująca podsumowanie o k licznikach
+extern void spaceSavingInit(spaceSaving *s, size_t k);
+
+// Funkcja liczącą kolejne wystąpienie skrótu
+extern void spaceSavingAdd(spaceSaving *s, uint64_t digest, size_t line);
+
+// Funkcja zwalniająca pamięć podsumowania
+extern void spaceSavingFree(spaceSaving *s);
+
+// Funkcja wypisująca najczęstsze grupy wierszy danych wejściowych
+extern void runHeavyHitters(const options *opts, wordProcessor process);
+
+#endif //HEAVY_H
@@ -0,0 +1,510 @@
+// Flaga potrzebna do poprawnego działania funkcji ftello i fileno
+#define _GNU_SOURCE
+
+#include "index.h"
+#include "multiset.h"
+#include "arena.h"
+#include "report.h"
+#include "similar.h"
+#include "digest.h"
+#include "recognizer.h"
+#include "slots.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <float.h>
+#include <sys/stat.h>
+
+// Liczba bajtów zapisywanych dla liczby long double. Format 80-bitowy
+// procesorów x86 zajmuje 10 pierwszych bajtów, a reszta to niezainicjowane
+// dopełnienie, którego nie należy zapisywać do pliku
+#if LDBL_MANT_DIG == 64 && (defined(__x86_64__) || defined(__i386__))
+#define FLOAT_BYTES 10
+#else
+#define FLOAT_BYTES sizeof(long double)
+#endif
+
+// Najmniejsza liczba bajtów grupy w pliku: skrót, rozmiary tablic
+// multizbioru, liczba wierszy i jeden numer wiersza
+#define MIN_GROUP_BYTES (sizeof(uint64_t) + 4 * sizeof(uint32_t) \
+                         + sizeof(uint64_t) + sizeof(size_t))
+
+/**
+ * Funkcja tworząca pusty indeks.
+ */
+groupIndex *indexCreate(void) {
+    groupIndex *x = malloc(sizeof(groupIndex));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (x == NULL)
+        exit(1);
+
+    x->groups = malloc(INDEX_DEFAULT_SLOTS * sizeof(indexGroup));
+    x->size = 0;
+    x->reserved = INDEX_DEFAULT_SLOTS;
+    x->slots = calloc(INDEX_DEFAULT_SLOTS, sizeof(size_t));
+    x->capacity = INDEX_DEFAULT_SLOTS;
+    x->memory = arenaCreate();
+
+    if (x->groups == NULL || x->slots == NULL)
+        exit(1);
+
+    return x;
+}
+
+/**
+ * Funkcja zwracająca miejsce tablicy haszującej dla zadanego skrótu:
+ * miejsce grupy z podobnym multizbiorem albo pierwsze wolne miejsce.
+ * x - indeks
+ * set - posortowany multizbiór
+ * digest - skrót multizbioru
+ */
+static size_t findSlot(groupIndex *x, multiset *set, uint64_t digest) {
+    size_t i = slotHome(digest, x->capacity);
+    indexGroup *g;
+
+    while (x->slots[i] != 0) {
+        g = &x->groups[x->slots[i] - 1];
+
+        if (g->digest == digest && similarSets(&g->set, set))
+            return i;
+
+        i = slotNext(i, x->capacity);
+    }
+
+    return i;
+}
+
+/**
+ * Funkcja zwracająca pierwsze wolne miejsce tablicy haszującej dla skrótu.
+ * x - indeks
+ * digest - skrót
+ */
+static size_t freeSlot(groupIndex *x, uint64_t digest) {
+    size_t i = slotHome(digest, x->capacity);
+
+    while (x->slots[i] != 0)
+        i = slotNext(i, x->capacity);
+
+    return i;
+}
+
+/**
+ * Funkcja podwajająca tablicę haszującą, gdy jest zapełniona w połowie.
+ * x - indeks
+ */
+static void growSlots(groupIndex *x) {
+    size_t *old = x->slots;
+    size_t oldCapacity = x->capacity;
+
+    x->capacity *= 2;
+    x->slots = calloc(x->capacity, sizeof(size_t));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (x->slots == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < oldCapacity; i++) {
+        if (old[i] != 0)
+            x->slots[freeSlot(x, x->groups[old[i] - 1].digest)] = old[i];
+    }
+
+    free(old);
+}
+
+/**
+ * Funkcja dopisująca numer wiersza do grupy. Tablica wierszy leży w arenie
+ * i jest podwajana, gdy jej rozmiar osiąga potęgę dwójki.
+ * x - indeks
+ * g - grupa
+ * line - numer wiersza, większy od wszystkich wierszy grupy
+ */
+void indexAppendLine(groupIndex *x, indexGroup *g, size_t line) {
+    if (g->size == 0)
+        g->lines = arenaAlloc(x->memory, sizeof(size_t), sizeof(size_t));
+    else if ((g->size & (g->size - 1)) == 0)
+        g->lines = arenaGrow(x->memory, g->lines, g->size * sizeof(size_t),
+                             2 * g->size * sizeof(size_t), sizeof(size_t));
+
+    g->lines[g->size++] = line;
+}
+
+/**
+ * Funkcja tworząca nową grupę z zadanym reprezentantem, bez szukania grupy
+ * podobnej. Pamięć słów multizbioru musi leżeć w arenie indeksu.
+ * x - indeks
+ * set - posortowany multizbiór
+ * digest - skrót multizbioru
+ */
+indexGroup *indexInsert(groupIndex *x, multiset *set, uint64_t digest) {
+    indexGroup *g;
+
+    if (2 * (x->size + 1) > x->capacity)
+        growSlots(x);
+
+    x->groups = expand(x->groups, sizeof(indexGroup), x->size, &x->reserved);
+    g = &x->groups[x->size++];
+    g->set = *set;
+    g->digest = digest;
+    g->lines = NULL;
+    g->size = 0;
+
+    x->slots[freeSlot(x, digest)] = x->size;
+    return g;
+}
+
+/**
+ * Funkcja dodająca wiersz do indeksu.
+ * Jeśli podobny wiersz już jest w indeksie, pamięć przydzielona przy
+ * parsowaniu nowego wiersza jest od razu zwalniana - indeks zajmuje pamięć
+ * proporcjonalną do liczby różnych wierszy. Koszt nie zależy od liczby
+ * wcześniej dodanych wierszy. Zwraca numer grupy, do której trafił wiersz.
+ * x - indeks
+ * set - posortowany multizbiór wiersza
+ * mark - stan areny indeksu sprzed parsowania wiersza
+ */
+size_t indexAdd(groupIndex *x, multiset *set, arenaMark mark) {
+    uint64_t digest = multisetDigest(set);
+    size_t slot = findSlot(x, set, digest);
+    indexGroup *g;
+
+    if (x->slots[slot] != 0) {
+        arenaRelease(x->memory, mark);
+        g = &x->groups[x->slots[slot] - 1];
+    }
+    else {
+        g = indexInsert(x, set, digest);
+    }
+
+    indexAppendLine(x, g, set->lineCount);
+    return (size_t) (g - x->groups);
+}
+
+/**
+ * Funkcja szukająca grupy podobnej do posortowanego multizbioru.
+ * Zwraca grupę albo NULL, gdy takiej grupy nie ma.
+ * x - indeks
+ * set - posortowany multizbiór
+ */
+indexGroup *indexFind(groupIndex *x, multiset *set) {
+    size_t slot = findSlot(x, set, multisetDigest(set));
+
+    if (x->slots[slot] == 0)
+        return NULL;
+
+    return &x->groups[x->slots[slot] - 1];
+}
+
+/**
+ * Funkcja przekazująca wszystkie grupy do modułu wypisującego. Grupy
+ * powstają w kolejności pierwszych wierszy, więc nie trzeba ich sortować.
+ * x - indeks
+ * r - moduł wypisujący
+ */
+void indexReport(groupIndex *x, reporter *r) {
+    for (size_t i = 0; i < x->size; i++)
+        reportGroupDigest(r, x->groups[i].lines, x->groups[i].size,
+                          x->groups[i].digest);
+}
+
+/**
+ * Funkcje zapisujące i odczytujące bajty pliku z indeksem.
+ * Zwracają fałsz w przypadku błędu.
+ * f - plik
+ * x - dane
+ * size - liczba bajtów
+ */
+bool writeBytes(FILE *f, const void *x, size_t size) {
+    return fwrite(x, 1, size, f) == size;
+}
+
+bool readBytes(FILE *f, void *x, size_t size) {
+    return fread(x, 1, size, f) == size;
+}
+
+/**
+ * Funkcja odczytująca bajty pliku z indeksem, nie więcej niż zostało ich
+ * w pliku. Rozmiary zapisane w uszkodzonym pliku nie mogą więc wymusić
+ * odczytu ani przydziału pamięci większego niż sam plik.
+ * f - plik
+ * x - miejsce na dane
+ * size - liczba bajtów
+ * left - liczba bajtów pozostałych w pliku, zmniejszana o size
+ */
+static bool readLimited(FILE *f, void *x, uint64_t size, uint64_t *left) {
+    if (size > *left || !readBytes(f, x, (size_t) size))
+        return false;
+
+    *left -= size;
+    return true;
+}
+
+/**
+ * Funkcja zwracająca liczbę bajtów pliku od bieżącego miejsca do końca.
+ * Zwraca fałsz, gdy nie da się jej ustalić.
+ * f - plik
+ * left - miejsce na liczbę bajtów
+ */
+static bool bytesLeft(FILE *f, uint64_t *left) {
+    struct stat info;
+    off_t position = ftello(f);
+
+    if (position < 0 || fstat(fileno(f), &info) != 0
+        || info.st_size < position)
+        return false;
+
+    *left = (uint64_t) (info.st_size - position);
+    return true;
+}
+
+/**
+ * Funkcja zapisująca posortowany multizbiór: liczby słów każdego typu,
+ * tablice liczb i "nieliczby" poprzedzone długościami. Liczby long double
+ * zajmują po FLOAT_BYTES bajtów, bez dopełnienia.
+ * f - plik
+ * set - multizbiór
+ */
+static bool saveMultiset(FILE *f, multiset *set) {
+    uint32_t sizes[4] = {set->sizeUnsigInts, set->sizeSigInts,
+                         set->sizeAnyFloats, set->sizeNotNumbers};
+    char **words = notNumbersOf(set);
+    long double *floats = anyFloatsOf(set);
+    bool ok = writeBytes(f, sizes, sizeof(sizes));
+    uint32_t length;
+
+    ok = ok && writeBytes(f, unsigIntsOf(set),
+                          sizes[0] * sizeof(unsigned long long));
+    ok = ok && writeBytes(f, sigIntsOf(set), sizes[1] * sizeof(long long));
+
+    for (uint32_t i = 0; ok && i < sizes[2]; i++)
+        ok = writeBytes(f, &floats[i], FLOAT_BYTES);
+
+    for (uint32_t i = 0; ok && i < sizes[3]; i++) {
+        length = (uint32_t) strlen(words[i]);
+        ok = writeBytes(f, &length, sizeof(length))
+             && writeBytes(f, words[i], length);
+    }
+
+    return ok;
+}
+
+/**
+ * Funkcja odczytująca multizbiór zapisany przez saveMultiset. Tablice
+ * dłuższe niż INLINE_* i słowa są przydzielane w arenie, ale dopiero po
+ * sprawdzeniu, że ich zapisane rozmiary mieszczą się w reszcie pliku.
+ * f - plik
+ * set - multizbiór do wypełnienia
+ * memory - arena indeksu
+ * left - liczba bajtów pozostałych w pliku
+ */
+static bool loadMultiset(FILE *f, multiset *set, arena *memory,
+                         uint64_t *left) {
+    uint32_t sizes[4], length;
+    uint64_t needed;
+    long double *floats;
+    char **words;
+
+    if (!readLimited(f, sizes, sizeof(sizes), left))
+        return false;
+
+    // Każde słowo zajmuje w pliku co najmniej swoją długość
+    needed = (uint64_t) sizes[0] * sizeof(unsigned long long)
+             + (uint64_t) sizes[1] * sizeof(long long)
+             + (uint64_t) sizes[2] * FLOAT_BYTES
+             + (uint64_t) sizes[3] * sizeof(length);
+
+    if (needed > *left)
+        return false;
+
+    set->sizeUnsigInts = sizes[0];
+    set->sizeSigInts = sizes[1];
+    set->sizeAnyFloats = sizes[2];
+    set->sizeNotNumbers = sizes[3];
+
+    if (sizes[0] > INLINE_INTS)
+        set->unsigInts.heap = arenaAlloc(memory,
+                                         sizes[0] * sizeof(unsigned long long),
+                                         sizeof(unsigned long long));
+    if (sizes[1] > INLINE_INTS)
+        set->sigInts.heap = arenaAlloc(memory, sizes[1] * sizeof(long long),
+                                       sizeof(long long));
+    if (sizes[2] > INLINE_FLOATS)
+        set->anyFloats.heap = arenaAlloc(memory,
+                                         sizes[2] * sizeof(long double),
+                                         sizeof(long double));
+    if (sizes[3] > INLINE_WORDS)
+        set->notNumbers.heap = arenaAlloc(memory, sizes[3] * sizeof(char *),
+                                          sizeof(char *));
+
+    if (!readLimited(f, unsigIntsOf(set),
+                     (uint64_t) sizes[0] * sizeof(unsigned long long), left)
+        || !readLimited(f, sigIntsOf(set),
+                        (uint64_t) sizes[1] * sizeof(long long), left))
+        return false;
+
+    floats = anyFloatsOf(set);
+    memset(floats, 0, sizes[2] * sizeof(long double));
+
+    for (uint32_t i = 0; i < sizes[2]; i++) {
+        if (!readLimited(f, &floats[i], FLOAT_BYTES, left))
+            return false;
+    }
+
+    words = notNumbersOf(set);
+
+    for (uint32_t i = 0; i < sizes[3]; i++) {
+        if (!readLimited(f, &length, sizeof(length), left) || length > *left)
+            return false;
+
+        words[i] = arenaAlloc(memory, (size_t) length + 1, 1);
+
+        if (!readLimited(f, words[i], length, left))
+            return false;
+
+        words[i][length] = '\0';
+    }
+
+    return true;
+}
+
+/**
+ * Funkcja zapisująca wszystkie grupy indeksu: ich liczbę, a dla każdej
+ * grupy skrót, reprezentanta i numery wierszy. Plik zapisywany jest
+ * w reprezentacji bieżącej maszyny. Zwraca fałsz w przypadku błędu.
+ * x - indeks
+ * f - plik
+ */
+bool indexSave(groupIndex *x, FILE *f) {
+    uint64_t groups = x->size, size, digest;
+    bool ok = writeBytes(f, &groups, sizeof(groups));
+
+    for (size_t i = 0; ok && i < x->size; i++) {
+        size = x->groups[i].size;
+        digest = x->groups[i].digest;
+        ok = writeBytes(f, &digest, sizeof(digest))
+             && saveMultiset(f, &x->groups[i].set)
+             && writeBytes(f, &size, sizeof(size))
+             && writeBytes(f, x->groups[i].lines, size * sizeof(size_t));
+    }
+
+    return ok;
+}
+
+/**
+ * Funkcja porównująca dwa numery wierszy do qsort.
+ * a - pierwszy numer
+ * b - drugi numer
+ */
+static int compareLines(const void *a, const void *b) {
+    size_t x = *((const size_t *) a);
+    size_t y = *((const size_t *) b);
+
+    if (x < y)
+        return -1;
+    else if (x > y)
+        return 1;
+    return 0;
+}
+
+/**
+ * Funkcja sprawdzająca, czy każdy wiersz odtworzonego indeksu należy do
+ * dokładnie jednej grupy.
+ * x - indeks
+ */
+static bool distinctLines(groupIndex *x) {
+    size_t total = 0, k = 0, *lines;
+    bool ok = true;
+
+    for (size_t i = 0; i < x->size; i++)
+        total += x->groups[i].size;
+
+    if (total < 2)
+        return true;
+
+    lines = malloc(total * sizeof(size_t));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (lines == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < x->size; i++) {
+        memcpy(&lines[k], x->groups[i].lines,
+               x->groups[i].size * sizeof(size_t));
+        k += x->groups[i].size;
+    }
+
+    qsort(lines, total, sizeof(size_t), compareLines);
+
+    for (size_t i = 1; ok && i < total; i++)
+        ok = lines[i] != lines[i - 1];
+
+    free(lines);
+    return ok;
+}
+
+/**
+ * Funkcja odtwarzająca grupy zapisane przez indexSave w pustym indeksie.
+ * Liczby grup i wierszy są sprawdzane z rozmiarem reszty pliku. Skrót
+ * reprezentanta jest liczony na nowo i musi się zgadzać z zapisanym, grupa
+ * nie może być podobna do wcześniejszej, numery wierszy (od 1) muszą rosnąć
+ * w grupie i między pierwszymi wierszami kolejnych grup, a każdy wiersz
+ * może należeć tylko do jednej grupy. Zwraca fałsz dla uszkodzonego pliku.
+ * x - pusty indeks
+ * f - plik
+ */
+bool indexLoad(groupIndex *x, FILE *f) {
+    uint64_t groups, size, digest, left;
+    size_t line, first = 0;
+    multiset set;
+    indexGroup *g;
+    bool ok = bytesLeft(f, &left)
+              && readLimited(f, &groups, sizeof(groups), &left)
+              && groups <= left / MIN_GROUP_BYTES;
+
+    for (uint64_t i = 0; ok && i < groups; i++) {
+        ok = readLimited(f, &digest, sizeof(digest), &left)
+             && loadMultiset(f, &set, x->memory, &left)
+             && readLimited(f, &size, sizeof(size), &left)
+             && size > 0 && size <= left / sizeof(size_t);
+
+        if (!ok)
+            break;
+
+        // Słowa z uszkodzonego pliku mogą nie być posortowane
+        set.overflow = false;
+        sortMultiset(&set);
+        ok = multisetDigest(&set) == digest
+             && x->slots[findSlot(x, &set, digest)] == 0;
+
+        if (!ok)
+            break;
+
+        g = indexInsert(x, &set, digest);
+
+        for (uint64_t j = 0; ok && j < size; j++) {
+            ok = readLimited(f, &line, sizeof(line), &left)
+                 && (j == 0 ? line > first : line > g->lines[j - 1]);
+
+            if (ok)
+                indexAppendLine(x, g, line);
+        }
+
+        if (ok) {
+            g->set.lineCount = g->lines[0];
+            first = g->lines[0];
+        }
+    }
+
+    return ok && distinctLines(x);
+}
+
+/**
+ * Funkcja zwalniająca pamięć indeksu razem z areną.
+ * x - indeks
+ */
+void indexDestroy(groupIndex *x) {
+    arenaDestroy(x->memory);
+    free(x->groups);
+    free(x->slots);
+    free(x);
+}
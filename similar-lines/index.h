@@ -0,0 +1,86 @@
+#include "multiset.h"
+#include "arena.h"
+#include "report.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef INDEX_H
+#define INDEX_H
+
+// Początkowa liczba miejsc w tablicy haszującej indeksu
+#define INDEX_DEFAULT_SLOTS 64
+
+/**
+ * Grupa podobnych wierszy w indeksie.
+ * set - posortowany multizbiór pierwszego wiersza grupy (reprezentant)
+ * digest - skrót reprezentanta
+ * lines - numery wierszy grupy w kolejności rosnącej
+ * size - liczba wierszy grupy
+ */
+struct indexGroup {
+    multiset set;
+    uint64_t digest;
+    size_t *lines;
+    size_t size;
+};
+typedef struct indexGroup indexGroup;
+
+/**
+ * Indeks grup podobnych wierszy, uzupełniany wiersz po wierszu.
+ * Grupy są trzymane w kolejności pojawienia się ich pierwszych wierszy,
+ * a tablica haszująca z adresowaniem otwartym wskazuje grupę po skrócie
+ * reprezentanta. Słowa reprezentantów i numery wierszy leżą w arenie
+ * indeksu, do której parser powinien przydzielać pamięć nowych wierszy.
+ * groups - wszystkie grupy
+ * size - liczba grup
+ * reserved - pamięć przydzielona tablicy groups
+ * slots - tablica haszująca: numer grupy zwiększony o 1, 0 - wolne miejsce
+ * capacity - liczba miejsc tablicy haszującej (potęga dwójki)
+ * memory - arena indeksu
+ */
+struct groupIndex {
+    indexGroup *groups;
+    size_t size;
+    size_t reserved;
+    size_t *slots;
+    size_t capacity;
+    arena *memory;
+};
+typedef struct groupIndex groupIndex;
+
+// Funkcja tworząca pusty indeks
+extern groupIndex *indexCreate(void);
+
+// Funkcja dodająca posortowany multizbiór sparsowany w arenie indeksu od
+// znacznika mark, zwraca numer grupy, do której trafił wiersz
+extern size_t indexAdd(groupIndex *x, multiset *set, arenaMark mark);
+
+// Funkcja tworząca nową grupę bez szukania podobnej (przy odtwarzaniu)
+extern indexGroup *indexInsert(groupIndex *x, multiset *set, uint64_t digest);
+
+// Funkcja szukająca grupy podobnej do posortowanego multizbioru
+extern indexGroup *indexFind(groupIndex *x, multiset *set);
+
+// Funkcja dopisująca numer wiersza do grupy
+extern void indexAppendLine(groupIndex *x, indexGroup *g, size_t line);
+
+// Funkcja przekazująca wszystkie grupy, w kolejności pierwszych wierszy,
+// do modułu wypisującego
+extern void indexReport(groupIndex *x, reporter *r);
+
+// Funkcje zapisujące i odczytujące bajty pliku, fałsz oznacza błąd
+extern bool writeBytes(FILE *f, const void *x, size_t size);
+extern bool readBytes(FILE *f, void *x, size_t size);
+
+// Funkcja zapisująca wszystkie grupy indeksu do pliku
+extern bool indexSave(groupIndex *x, FILE *f);
+
+// Funkcja odtwarzająca grupy zapisane przez indexSave w pustym indeksie
+extern bool indexLoad(groupIndex *x, FILE *f);
+
+// Funkcja zwalniająca pamięć indeksu
+extern void indexDestroy(groupIndex *x);
+
+#endif //INDEX_H
@@ -0,0 +1,561 @@
+#include "jaccard.h"
+#include "multiset.h"
+#include "report.h"
+#include "digest.h"
+#include "similar.h"
+#include "slots.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+// Oznaczenie kandydata odrzuconego przez filtr pozycyjny
+#define PRUNED (-1)
+
+/**
+ * Słownik elementów wszystkich wierszy z tablicą haszującą.
+ * tokens - różne elementy w kolejności pierwszego wystąpienia
+ * count - liczba różnych elementów
+ * slots - tablica haszująca: numer elementu zwiększony o 1, 0 - wolne miejsce
+ * capacity - liczba miejsc tablicy haszującej (potęga dwójki)
+ */
+struct tokenTable {
+    jaccardToken *tokens;
+    size_t count;
+    size_t *slots;
+    size_t capacity;
+};
+typedef struct tokenTable tokenTable;
+
+/**
+ * Funkcja sprawdzająca, czy dwa elementy są równe.
+ * a - pierwszy element
+ * b - drugi element
+ */
+static bool sameToken(const jaccardToken *a, const jaccardToken *b) {
+    if (a->hash != b->hash || a->type != b->type
+        || a->occurrence != b->occurrence)
+        return false;
+
+    switch (a->type) {
+        case 0:
+            return a->value.unsigInt == b->value.unsigInt;
+        case 1:
+            return a->value.sigInt == b->value.sigInt;
+        case 2:
+            return a->value.anyFloat == b->value.anyFloat;
+        default:
+            return strcmp(a->value.notNumber, b->value.notNumber) == 0;
+    }
+}
+
+/**
+ * Funkcja zwracająca numer elementu w słowniku, dodając go przy pierwszym
+ * wystąpieniu. Liczy też wiersze, w których element występuje - każdy
+ * element występuje w wierszu najwyżej raz.
+ * t - słownik z miejscem na nowy element
+ * token - element z wypełnionym skrótem
+ */
+static uint32_t internToken(tokenTable *t, const jaccardToken *token) {
+    size_t i = slotHome(token->hash, t->capacity);
+
+    while (t->slots[i] != 0) {
+        if (sameToken(&t->tokens[t->slots[i] - 1], token)) {
+            ++t->tokens[t->slots[i] - 1].frequency;
+            return (uint32_t) (t->slots[i] - 1);
+        }
+
+        i = slotNext(i, t->capacity);
+    }
+
+    t->tokens[t->count] = *token;
+    t->tokens[t->count].frequency = 1;
+    t->slots[i] = ++t->count;
+    return (uint32_t) (t->count - 1);
+}
+
+/**
+ * Funkcja zamieniająca posortowany multizbiór na numery elementów słownika.
+ * Równe słowa leżą obok siebie, więc numer wystąpienia rośnie w ich ciągu.
+ * t - słownik
+ * set - posortowany multizbiór
+ * ids - miejsce na numery elementów
+ */
+static void collectTokens(tokenTable *t, multiset *set, uint32_t *ids) {
+    unsigned long long *unsigInts = unsigIntsOf(set);
+    long long *sigInts = sigIntsOf(set);
+    long double *anyFloats = anyFloatsOf(set);
+    char **notNumbers = notNumbersOf(set);
+    size_t count = 0;
+    jaccardToken token;
+
+    token.type = 0;
+    for (uint32_t i = 0; i < set->sizeUnsigInts; i++) {
+        token.occurrence = i > 0 && unsigInts[i] == unsigInts[i - 1]
+                           ? token.occurrence + 1 : 0;
+        token.value.unsigInt = unsigInts[i];
+        token.hash = digestCombine(unsigInts[i], token.occurrence);
+        ids[count++] = internToken(t, &token);
+    }
+
+    token.type = 1;
+    for (uint32_t i = 0; i < set->sizeSigInts; i++) {
+        token.occurrence = i > 0 && sigInts[i] == sigInts[i - 1]
+                           ? token.occurrence + 1 : 0;
+        token.value.sigInt = sigInts[i];
+        token.hash = digestCombine(digestCombine(1, (uint64_t) sigInts[i]),
+                                   token.occurrence);
+        ids[count++] = internToken(t, &token);
+    }
+
+    token.type = 2;
+    for (uint32_t i = 0; i < set->sizeAnyFloats; i++) {
+        token.occurrence = i > 0 && anyFloats[i] == anyFloats[i - 1]
+                           ? token.occurrence + 1 : 0;
+        token.value.anyFloat = anyFloats[i];
+        token.hash = digestCombine(digestCombine(2, digestFloat(anyFloats[i])),
+                                   token.occurrence);
+        ids[count++] = internToken(t, &token);
+    }
+
+    token.type = 3;
+    for (uint32_t i = 0; i < set->sizeNotNumbers; i++) {
+        token.occurrence = i > 0
+                           && strcmp(notNumbers[i], notNumbers[i - 1]) == 0
+                           ? token.occurrence + 1 : 0;
+        token.value.notNumber = notNumbers[i];
+        token.hash = digestCombine(digestCombine(3,
+                                                 digestWord(notNumbers[i])),
+                                   token.occurrence);
+        ids[count++] = internToken(t, &token);
+    }
+}
+
+/**
+ * Zmienna używana przez funkcję compareRarity, bo qsort nie przekazuje
+ * dodatkowego argumentu.
+ */
+static const jaccardToken *rarityTokens;
+
+/**
+ * Funkcja porównująca numery elementów do qsort - najpierw rzadsze
+ * elementy, a przy równej liczbie wierszy wcześniejsze.
+ * a - pierwszy numer
+ * b - drugi numer
+ */
+static int compareRarity(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *) a;
+    uint32_t y = *(const uint32_t *) b;
+
+    if (rarityTokens[x].frequency != rarityTokens[y].frequency)
+        return rarityTokens[x].frequency < rarityTokens[y].frequency ? -1 : 1;
+
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Funkcja porównująca liczby do qsort.
+ * a - pierwsza liczba
+ * b - druga liczba
+ */
+static int compareIds(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *) a;
+    uint32_t y = *(const uint32_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Zmienna używana przez funkcję compareLengths, bo qsort nie przekazuje
+ * dodatkowego argumentu.
+ */
+static const size_t *lengthOffsets;
+
+/**
+ * Funkcja porównująca numery multizbiorów do qsort - najpierw krótsze,
+ * a przy równej liczbie słów wcześniejsze.
+ * a - pierwszy numer
+ * b - drugi numer
+ */
+static int compareLengths(const void *a, const void *b) {
+    size_t x = *(const size_t *) a;
+    size_t y = *(const size_t *) b;
+    size_t lx = lengthOffsets[x + 1] - lengthOffsets[x];
+    size_t ly = lengthOffsets[y + 1] - lengthOffsets[y];
+
+    if (lx != ly)
+        return lx < ly ? -1 : 1;
+
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Funkcja zwracająca najmniejszą liczbę wspólnych elementów, przy której
+ * zbiory o lx i ly elementach mają podobieństwo Jaccarda co najmniej t:
+ * o / (lx + ly - o) >= t wtedy i tylko wtedy, gdy o >= t / (1 + t) (lx + ly).
+ * lx, ly - liczby elementów zbiorów
+ * t - próg podobieństwa
+ */
+static size_t requiredOverlap(size_t lx, size_t ly, double t) {
+    double o = ceil(t / (1 + t) * (double) (lx + ly) - JACCARD_ROUNDING);
+
+    // Zbiory bez wspólnych elementów mają podobieństwo 0
+    return o < 1 ? 1 : (size_t) o;
+}
+
+/**
+ * Funkcja zwracająca długość prefiksu zbioru o lx elementach, w którym
+ * musi leżeć wspólny element z każdym zbiorem o podobieństwie co najmniej t.
+ * lx - liczba elementów zbioru
+ * t - próg podobieństwa
+ */
+static size_t probePrefix(size_t lx, double t) {
+    double o = ceil(t * (double) lx - JACCARD_ROUNDING);
+    return lx - (o < 1 ? 1 : (size_t) o) + 1;
+}
+
+/**
+ * Funkcja zwracająca liczbę wspólnych elementów dwóch rosnących ciągów.
+ * x, y - ciągi
+ * lx, ly - długości ciągów
+ */
+static size_t overlap(const uint32_t *x, size_t lx, const uint32_t *y,
+                      size_t ly) {
+    size_t i = 0, j = 0, count = 0;
+
+    while (i < lx && j < ly) {
+        if (x[i] == y[j]) {
+            ++count;
+            ++i;
+            ++j;
+        }
+        else if (x[i] < y[j]) {
+            ++i;
+        }
+        else {
+            ++j;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Funkcja zwracająca reprezentanta zbioru w strukturze find-union,
+ * ze skracaniem ścieżek o połowę.
+ * parent - rodzice w strukturze find-union
+ * x - element
+ */
+static size_t findRoot(size_t *parent, size_t x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+
+    return x;
+}
+
+/**
+ * Funkcja łącząca zbiory dwóch elementów. Reprezentantem zostaje mniejszy
+ * numer, czyli wcześniejszy wiersz.
+ * parent - rodzice w strukturze find-union
+ * x, y - elementy
+ */
+static void unite(size_t *parent, size_t x, size_t y) {
+    x = findRoot(parent, x);
+    y = findRoot(parent, y);
+
+    if (x < y)
+        parent[y] = x;
+    else if (y < x)
+        parent[x] = y;
+}
+
+/**
+ * Funkcja przekazująca do wypisania spójne składowe, w kolejności pierwszych
+ * wierszy, z wierszami każdej składowej w kolejności rosnącej.
+ * set - multizbiory
+ * size - liczba multizbiorów
+ * parent - rodzice w strukturze find-union
+ * r - moduł wypisujący grupy
+ */
+static void reportComponents(multiset *set, size_t size, size_t *parent,
+                             reporter *r) {
+    size_t *lines = malloc((size + 1) * sizeof(size_t));
+    size_t *start = calloc(size + 1, sizeof(size_t));
+    size_t *fill = malloc((size + 1) * sizeof(size_t));
+    size_t root;
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (lines == NULL || start == NULL || fill == NULL)
+        exit(1);
+
+    // Sortowanie przez zliczanie wierszy według reprezentantów składowych
+    for (size_t i = 0; i < size; i++)
+        ++start[findRoot(parent, i) + 1];
+    for (size_t i = 0; i < size; i++)
+        start[i + 1] += start[i];
+
+    memcpy(fill, start, (size + 1) * sizeof(size_t));
+
+    for (size_t i = 0; i < size; i++) {
+        root = findRoot(parent, i);
+        lines[fill[root]++] = set[i].lineCount;
+    }
+
+    // Reprezentant składowej jest jej pierwszym wierszem
+    for (size_t i = 0; i < size; i++) {
+        if (parent[i] == i)
+            reportGroup(r, lines + start[i], start[i + 1] - start[i], &set[i]);
+    }
+
+    free(lines);
+    free(start);
+    free(fill);
+}
+
+/**
+ * Funkcja łącząca od razu wiersze z równymi multizbiorami, które mają
+ * podobieństwo 1. Dalej porównywane są tylko różne multizbiory, więc
+ * wielokrotnie powtórzone wiersze nie wydłużają list odwróconych.
+ * Zwraca liczbę różnych multizbiorów.
+ * set - posortowane multizbiory
+ * size - liczba multizbiorów
+ * parent - rodzice w strukturze find-union do wypełnienia
+ * distinct - miejsce na numery pierwszych wierszy różnych multizbiorów
+ */
+static size_t collapseDuplicates(multiset *set, size_t size, size_t *parent,
+                                 size_t *distinct) {
+    size_t capacity = 1, count = 0, i;
+    size_t *slots;
+    uint64_t *digests = malloc((size + 1) * sizeof(uint64_t));
+
+    while (capacity < 2 * (size + 1))
+        capacity *= 2;
+
+    slots = calloc(capacity, sizeof(size_t));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (digests == NULL || slots == NULL)
+        exit(1);
+
+    for (size_t j = 0; j < size; j++) {
+        digests[j] = multisetDigest(&set[j]);
+        i = slotHome(digests[j], capacity);
+
+        while (slots[i] != 0
+               && (digests[slots[i] - 1] != digests[j]
+                   || !similarSets(&set[slots[i] - 1], &set[j])))
+            i = slotNext(i, capacity);
+
+        if (slots[i] != 0) {
+            parent[j] = slots[i] - 1;
+        }
+        else {
+            slots[i] = j + 1;
+            parent[j] = j;
+            distinct[count++] = j;
+        }
+    }
+
+    free(digests);
+    free(slots);
+    return count;
+}
+
+/**
+ * Funkcja znajdująca wszystkie pary wierszy o podobieństwie Jaccarda
+ * multizbiorów co najmniej threshold i przekazująca do wypisania grupy
+ * będące spójnymi składowymi grafu tych par. Wynik jest dokładny.
+ * Elementy są numerowane od najrzadszych, więc prefiksy wierszy składają się
+ * z rzadkich elementów. Dwa wiersze mogą być podobne tylko wtedy, gdy mają
+ * wspólny element w prefiksach (filtr prefiksowy), a długości wierszy
+ * i pozycje wspólnych elementów ograniczają z góry nakładanie się (filtr
+ * długości i filtr pozycyjny, jak w algorytmie PPJoin). Wiersze są
+ * przeglądane od najkrótszych, a do list odwróconych trafiają tylko
+ * prefiksy wierszy już przejrzanych. Dokładnie sprawdzani są tylko
+ * kandydaci, którzy przeszli wszystkie filtry.
+ * Przy progu 1 grupy są takie same jak przy porównywaniu dokładnym.
+ * set - posortowane multizbiory
+ * size - liczba multizbiorów
+ * r - moduł wypisujący grupy
+ * threshold - próg podobieństwa z przedziału (0, 1]
+ */
+void findSimilarJaccard(multiset *set, size_t size, reporter *r,
+                        double threshold) {
+    size_t *parent = malloc((size + 1) * sizeof(size_t));
+    size_t *distinct = malloc((size + 1) * sizeof(size_t));
+    size_t total, *offsets, *order, *candidates, *listStart, *listSize;
+    size_t records, x, y, lx, ly, prefix, indexed, candidateCount, alpha;
+    size_t bound;
+    uint32_t *ids, *rank, *sorted, w;
+    jaccardPosting *postings;
+    tokenTable t;
+    int *counts;
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (parent == NULL || distinct == NULL)
+        exit(1);
+
+    // Dalej rekordami są tylko różne multizbiory set[distinct[x]]
+    records = collapseDuplicates(set, size, parent, distinct);
+    offsets = malloc((records + 1) * sizeof(size_t));
+    order = malloc((records + 1) * sizeof(size_t));
+    counts = calloc(records + 1, sizeof(int));
+    candidates = malloc((records + 1) * sizeof(size_t));
+
+    if (offsets == NULL || order == NULL || counts == NULL
+        || candidates == NULL)
+        exit(1);
+
+    offsets[0] = 0;
+    for (size_t i = 0; i < records; i++) {
+        multiset *s = &set[distinct[i]];
+        offsets[i + 1] = offsets[i] + s->sizeUnsigInts + s->sizeSigInts
+                         + s->sizeAnyFloats + s->sizeNotNumbers;
+    }
+
+    total = offsets[records];
+    ids = malloc((total + 1) * sizeof(uint32_t));
+    t.tokens = malloc((total + 1) * sizeof(jaccardToken));
+    t.count = 0;
+    t.capacity = 1;
+
+    while (t.capacity < 2 * (total + 1))
+        t.capacity *= 2;
+
+    t.slots = calloc(t.capacity, sizeof(size_t));
+
+    if (ids == NULL || t.tokens == NULL || t.slots == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < records; i++)
+        collectTokens(&t, &set[distinct[i]], ids + offsets[i]);
+
+    free(t.slots);
+
+    // Numeracja elementów od najrzadszych i sortowanie elementów wierszy
+    sorted = malloc((t.count + 1) * sizeof(uint32_t));
+    rank = malloc((t.count + 1) * sizeof(uint32_t));
+
+    if (sorted == NULL || rank == NULL)
+        exit(1);
+
+    for (uint32_t i = 0; i < t.count; i++)
+        sorted[i] = i;
+
+    rarityTokens = t.tokens;
+    qsort(sorted, t.count, sizeof(uint32_t), compareRarity);
+
+    for (uint32_t i = 0; i < t.count; i++)
+        rank[sorted[i]] = i;
+
+    for (size_t i = 0; i < total; i++)
+        ids[i] = rank[ids[i]];
+
+    for (size_t i = 0; i < records; i++)
+        qsort(ids + offsets[i], offsets[i + 1] - offsets[i],
+              sizeof(uint32_t), compareIds);
+
+    free(sorted);
+    free(rank);
+    free(t.tokens);
+
+    for (size_t i = 0; i < records; i++)
+        order[i] = i;
+
+    lengthOffsets = offsets;
+    qsort(order, records, sizeof(size_t), compareLengths);
+
+    // Listy odwrócone leżą w jednej tablicy - miejsce każdej listy wynika
+    // z liczby prefiksów, w których występuje jej element
+    listStart = calloc(t.count + 1, sizeof(size_t));
+    listSize = calloc(t.count + 1, sizeof(size_t));
+
+    if (listStart == NULL || listSize == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < records; i++) {
+        lx = offsets[i + 1] - offsets[i];
+        indexed = lx - requiredOverlap(lx, lx, threshold) + 1;
+
+        for (size_t k = 0; k < indexed; k++)
+            ++listStart[ids[offsets[i] + k] + 1];
+    }
+
+    for (size_t i = 0; i < t.count; i++)
+        listStart[i + 1] += listStart[i];
+
+    postings = malloc((listStart[t.count] + 1) * sizeof(jaccardPosting));
+
+    if (postings == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < records; i++) {
+        x = order[i];
+        lx = offsets[x + 1] - offsets[x];
+        prefix = probePrefix(lx, threshold);
+        candidateCount = 0;
+
+        for (size_t k = 0; k < prefix; k++) {
+            w = ids[offsets[x] + k];
+
+            for (size_t p = listStart[w]; p < listStart[w] + listSize[w];
+                 p++) {
+                y = postings[p].record;
+                ly = offsets[y + 1] - offsets[y];
+
+                // Filtr długości - krótsze wiersze nie mogą być podobne
+                if ((double) ly < threshold * (double) lx - JACCARD_ROUNDING
+                    || counts[y] == PRUNED)
+                    continue;
+
+                if (counts[y] == 0)
+                    candidates[candidateCount++] = y;
+
+                // Filtr pozycyjny - górne ograniczenie nakładania się
+                alpha = requiredOverlap(lx, ly, threshold);
+                bound = 1 + (lx - k - 1 < ly - postings[p].position - 1
+                             ? lx - k - 1 : ly - postings[p].position - 1);
+
+                if ((size_t) counts[y] + bound >= alpha)
+                    ++counts[y];
+                else
+                    counts[y] = PRUNED;
+            }
+        }
+
+        for (size_t c = 0; c < candidateCount; c++) {
+            y = candidates[c];
+            ly = offsets[y + 1] - offsets[y];
+
+            if (counts[y] != PRUNED
+                && overlap(ids + offsets[x], lx, ids + offsets[y], ly)
+                   >= requiredOverlap(lx, ly, threshold))
+                unite(parent, distinct[x], distinct[y]);
+
+            counts[y] = 0;
+        }
+
+        indexed = lx - requiredOverlap(lx, lx, threshold) + 1;
+
+        for (size_t k = 0; k < indexed; k++) {
+            w = ids[offsets[x] + k];
+            postings[listStart[w] + listSize[w]].record = x;
+            postings[listStart[w] + listSize[w]].position = (uint32_t) k;
+            ++listSize[w];
+        }
+    }
+
+    reportComponents(set, size, parent, r);
+
+    free(parent);
+    free(distinct);
+    free(offsets);
+    free(order);
+    free(counts);
+    free(candidates);
+    free(ids);
+    free(listStart);
+    free(listSize);
+    free(postings);
+}
@@ -0,0 +1,53 @@
+#include "multiset.h"
+#include "report.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef JACCARD_H
+#define JACCARD_H
+
+// Zapas chroniący progi nakładania się przed błędami zaokrągleń
+#define JACCARD_ROUNDING 1e-9
+
+/**
+ * Słowo z określonym numerem wystąpienia w multizbiorze. Kolejne wystąpienia
+ * tego samego słowa w wierszu są różnymi elementami zbioru, więc podobieństwo
+ * Jaccarda takich zbiorów jest podobieństwem Jaccarda multizbiorów.
+ * hash - skrót słowa razem z typem i numerem wystąpienia
+ * type - typ słowa: 0 - liczba nieujemna, 1 - ujemna, 2 - zmiennoprzecinkowa,
+ *        3 - "nieliczba"
+ * occurrence - numer wystąpienia słowa w wierszu
+ * frequency - liczba wierszy, w których występuje element
+ * unsigInt, sigInt, anyFloat, notNumber - wartość słowa
+ */
+struct jaccardToken {
+    uint64_t hash;
+    uint32_t type;
+    uint32_t occurrence;
+    size_t frequency;
+    union {
+        unsigned long long unsigInt;
+        long long sigInt;
+        long double anyFloat;
+        const char *notNumber;
+    } value;
+};
+typedef struct jaccardToken jaccardToken;
+
+/**
+ * Wpis listy odwróconej: wiersz, w którego prefiksie leży element.
+ * record - numer multizbioru
+ * position - pozycja elementu w multizbiorze
+ */
+struct jaccardPosting {
+    size_t record;
+    uint32_t position;
+};
+typedef struct jaccardPosting jaccardPosting;
+
+// Funkcja znajdująca grupy wierszy połączonych podobieństwem Jaccarda
+// co najmniej threshold i przekazująca je do wypisania
+extern void findSimilarJaccard(multiset *set, size_t size, reporter *r,
+                               double threshold);
+
+#endif //JACCARD_H
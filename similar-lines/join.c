@@ -0,0 +1,172 @@
+#include "join.h"
+#include "index.h"
+#include "multiset.h"
+#include "parser.h"
+#include "similar.h"
+#include "arena.h"
+#include "reader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * Funkcja budująca indeks grup wierszy pliku odniesienia. Wiersze podobne
+ * do wcześniejszych zwalniają od razu swoją pamięć, więc indeks zajmuje
+ * pamięć proporcjonalną do liczby różnych wierszy pliku. Kończy program
+ * z błędem, gdy pliku nie można otworzyć.
+ * path - ścieżka pliku odniesienia
+ * x - pusty indeks
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ */
+static void buildIndex(const char *path, groupIndex *x,
+                       wordProcessor process) {
+    int fd = open(path, O_RDONLY);
+    lineReader *reader;
+    arenaMark mark;
+    multiset set;
+    parser p;
+
+    if (fd < 0) {
+        fprintf(stderr, "Nie mozna otworzyc pliku %s\n", path);
+        exit(1);
+    }
+
+    reader = readerCreate(fd);
+    // Błędne wiersze pliku odniesienia są pomijane bez komunikatów, które
+    // myliłyby się z komunikatami o wierszach danych wejściowych
+    parserInit(&p, reader, x->memory, process, false);
+
+    while (true) {
+        mark = arenaGetMark(x->memory);
+
+        if (!parseLine(&p, &set))
+            break;
+
+        sortMultiset(&set);
+        indexAdd(x, &set, mark);
+    }
+
+    readerDestroy(reader);
+    close(fd);
+}
+
+/**
+ * Funkcja zapisująca indeks pliku odniesienia razem z regułami
+ * rozpoznawania słów. Kończy program z błędem, gdy zapis się nie uda.
+ * path - ścieżka pliku z indeksem
+ * x - indeks
+ * rules - reguły rozpoznawania słów
+ */
+static void saveIndex(const char *path, groupIndex *x, uint32_t rules) {
+    uint32_t version = JOIN_VERSION;
+    FILE *f = fopen(path, "wb");
+    bool ok = f != NULL
+              && writeBytes(f, JOIN_MAGIC, JOIN_MAGIC_SIZE)
+              && writeBytes(f, &version, sizeof(version))
+              && writeBytes(f, &rules, sizeof(rules))
+              && indexSave(x, f);
+
+    if (f != NULL)
+        ok = fclose(f) == 0 && ok;
+
+    if (!ok) {
+        fprintf(stderr, "Nie udalo sie zapisac indeksu %s\n", path);
+        exit(1);
+    }
+}
+
+/**
+ * Funkcja odczytująca indeks zapisany przez saveIndex. Kończy program
+ * z błędem dla brakującego lub uszkodzonego pliku oraz dla indeksu
+ * zbudowanego przy innych regułach rozpoznawania słów.
+ * path - ścieżka pliku z indeksem
+ * x - pusty indeks
+ * rules - reguły rozpoznawania słów
+ */
+static void loadIndex(const char *path, groupIndex *x, uint32_t rules) {
+    char magic[JOIN_MAGIC_SIZE];
+    uint32_t version, savedRules;
+    FILE *f = fopen(path, "rb");
+    bool ok = f != NULL
+              && readBytes(f, magic, JOIN_MAGIC_SIZE)
+              && memcmp(magic, JOIN_MAGIC, JOIN_MAGIC_SIZE) == 0
+              && readBytes(f, &version, sizeof(version))
+              && version == JOIN_VERSION
+              && readBytes(f, &savedRules, sizeof(savedRules))
+              && savedRules == rules
+              && indexLoad(x, f);
+
+    if (f != NULL)
+        fclose(f);
+
+    if (!ok) {
+        fprintf(stderr, "Bledny indeks %s\n", path);
+        exit(1);
+    }
+}
+
+/**
+ * Funkcja łącząca dane wejściowe z plikiem odniesienia. Indeks grup pliku
+ * odniesienia jest budowany raz (albo odczytywany z pliku), a dane wejściowe
+ * są przeglądane strumieniowo - pamięć każdego wiersza jest zwalniana po jego
+ * sprawdzeniu, więc pamięć zależy tylko od pliku odniesienia. Dla każdego
+ * wiersza N podobnego do grupy pliku odniesienia wypisywany jest wiersz
+ * "N L1 L2 ...", gdzie L1 < L2 < ... to wiersze tej grupy. Z opcją
+ * --save-index zbudowany indeks jest tylko zapisywany do pliku.
+ * opts - opcje programu
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ */
+void runJoin(const options *opts, wordProcessor process) {
+    groupIndex *x = indexCreate();
+    uint32_t rules = optionsRules(opts);
+    arena *memory;
+    lineReader *reader;
+    arenaMark mark;
+    indexGroup *g;
+    multiset set;
+    parser p;
+
+    if (opts->join != NULL)
+        buildIndex(opts->join, x, process);
+    else
+        loadIndex(opts->loadIndex, x, rules);
+
+    if (opts->saveIndex != NULL) {
+        saveIndex(opts->saveIndex, x, rules);
+        indexDestroy(x);
+        return;
+    }
+
+    memory = arenaCreate();
+    reader = readerCreate(STDIN_FILENO);
+    parserInit(&p, reader, memory, process, true);
+
+    while (true) {
+        mark = arenaGetMark(memory);
+
+        if (!parseLine(&p, &set))
+            break;
+
+        sortMultiset(&set);
+        g = indexFind(x, &set);
+
+        if (g != NULL) {
+            printf("%zu", set.lineCount);
+
+            for (size_t i = 0; i < g->size; i++)
+                printf(" %zu", g->lines[i]);
+
+            printf("\n");
+        }
+
+        arenaRelease(memory, mark);
+    }
+
+    readerDestroy(reader);
+    arenaDestroy(memory);
+    indexDestroy(x);
+}
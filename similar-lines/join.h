@@ -0,0 +1,16 @@
+#include "options.h"
+#include "recognizer.h"
+
+#ifndef JOIN_H
+#define JOIN_H
+
+// Nagłówek pliku z zapisanym indeksem: sygnatura i wersja
+#define JOIN_MAGIC "SLIX"
+#define JOIN_MAGIC_SIZE 4
+#define JOIN_VERSION 2
+
+// Funkcja wypisująca wiersze danych wejściowych podobne do wierszy
+// pliku odniesienia razem z ich grupami
+extern void runJoin(const options *opts, wordProcessor process);
+
+#endif //JOIN_H
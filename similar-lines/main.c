@@ -6,29 +6,141 @@
 #include "multiset.h"
 #include "parser.h"
 #include "similar.h"
+#include "arena.h"
+#include "options.h"
+#include "report.h"
+#include "counters.h"
+#include "recognizer.h"
+#include "shard.h"
+#include "checkpoint.h"
+#include "follow.h"
+#include "compact.h"
+#include "tolerance.h"
+#include "jaccard.h"
+#include "estimate.h"
+#include "heavy.h"
+#include "join.h"
+#include "window.h"
+#include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
-int main() {
+int main(int argc, char *argv[]) {
     size_t size;
+    options opts;
+    reporter r;
+    counters c;
+    compactStats stats;
     // Główny element programu - tablica multizbiorów, która będzie
     // przechowywać wszystkie slowa z kolejnych linii danych wejściowych
     multiset *text = malloc(DEFAULT_SIZE * sizeof(multiset));
+    // Arena, do której trafiają wszystkie słowa i tablice słów z wierszy
+    arena *memory = arenaCreate();
 
     // Awaryjne wyjście z programu w przypadku braku pamięci
     if (text == NULL)
     	exit(1);
 
-    // Parsowanie danych wejściowych
-    text = loadInput(text, &size);
+    parseOptions(&opts, argc, argv);
+    // Wariant rozpoznawania słów jest wybierany raz, dla całego programu
+    wordProcessor process = selectWordProcessor(opts.caseSensitive,
+                                                opts.noOctal, opts.hexAsWord);
 
-    // Porównywanie i wypisywanie podobnych multizbiorów
-    text = sortAll(text, size);
-    findSimilar(text, size);
+    // Tryby, które nie wypisują grup w zwykły sposób - łączenie z plikiem
+    // odniesienia, okno ostatnich wierszy, śledzenie pliku, szacowanie
+    // liczby różnych wierszy i najczęstsze grupy
+    if (opts.join != NULL || opts.loadIndex != NULL || opts.window > 0
+        || opts.windowSeconds > 0 || opts.follow != NULL || opts.estimate
+        || opts.heavyHitters > 0) {
+        if (opts.join != NULL || opts.loadIndex != NULL)
+            runJoin(&opts, process);
+        else if (opts.window > 0 || opts.windowSeconds > 0)
+            runWindow(&opts, process);
+        else if (opts.follow != NULL)
+            runFollow(&opts, process);
+        else if (opts.estimate)
+            runEstimate(&opts, process);
+        else
+            runHeavyHitters(&opts, process);
+
+        freeOptions(&opts);
+        arenaDestroy(memory);
+        free(text);
+
+        return 0;
+    }
+
+    reporterInit(&r, &opts, STDOUT_FILENO);
+    // Liczniki wydajności faz, aktywne tylko z opcją --profile-counters
+    countersOpen(&c, opts.profileCounters);
+
+    // Tryby pracy bez tablicy wszystkich multizbiorów - z zapisem stanu
+    // albo z wierszami dzielonymi między procesy potomne
+    if (opts.checkpoint != NULL || opts.shards > 1) {
+        if (opts.checkpoint != NULL)
+            runCheckpointed(&opts, process, &r, &c);
+        else
+            runShards(&opts, process, &r, &c);
+
+        reportFinish(&r);
+        countersClose(&c);
+        freeOptions(&opts);
+        arenaDestroy(memory);
+        free(text);
 
-    // Zwalnianie pamięci po wszystkich wytworzonych multizbiorach
-    for (size_t i = 0; i < size; i++)
-        freeMultiset(&(text[i]));
+        return 0;
+    }
+
+    // Parsowanie danych wejściowych razem z sortowaniem - w puli wątków albo
+    // w wątku głównym, z sortowaniem w osobnym etapie
+    countersStart(&c);
+    if (opts.threads > 1)
+        text = loadInputParallel(text, &size, memory, process, opts.threads);
+    else
+        text = loadInput(text, &size, memory, process, opts.sortThreads);
+    countersStop(&c, "loadInput+sort");
+
+    // Kompaktowanie pamięci słów, zanim zaczną się dalsze fazy
+    if (opts.compact) {
+        countersStart(&c);
+        text = compactAll(text, size, &memory, &stats);
+        countersStop(&c, "compact");
+
+        if (opts.stats)
+            printCompactStats(&stats);
+    }
+    else if (opts.stats) {
+        arenaStats usage = arenaGetStats(memory);
+        fprintf(stderr, "STATS arena: zajete %zu B, zarezerwowane %zu B\n",
+                usage.used, usage.reserved);
+    }
+
+    if (opts.stats) {
+        tokenCacheStats cached = tokenCacheGetStats();
+        fprintf(stderr, "STATS pamiec podreczna slow: trafienia %zu, "
+                        "chybienia %zu\n", cached.hits, cached.misses);
+    }
+
+    // Porównywanie i wypisywanie podobnych multizbiorów
+    countersStart(&c);
+    if (opts.floatEpsilon > 0) {
+        tolerance t;
+        toleranceInit(&t, opts.floatEpsilon, opts.floatRelative);
+        findSimilarWithin(text, size, &r, &t);
+    }
+    else if (opts.jaccard > 0) {
+        findSimilarJaccard(text, size, &r, opts.jaccard);
+    }
+    else {
+        findSimilar(text, size, &r);
+    }
+    reportFinish(&r);
+    countersStop(&c, "findSimilar");
+    countersClose(&c);
 
+    // Zwalnianie pamięci po wszystkich multizbiorach - naraz całą areną
+    freeOptions(&opts);
+    arenaDestroy(memory);
     free(text);
 
     return 0;
@@ -1,28 +1,88 @@
 #include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #ifndef MULTISET_H
 #define MULTISET_H
 
+// Liczba liczb całkowitych danego typu trzymanych wewnątrz multizbioru
+#define INLINE_INTS 2
+
+// Liczba liczb zmiennoprzecinkowych trzymanych wewnątrz multizbioru
+#define INLINE_FLOATS 1
+
+// Liczba "nieliczb" trzymanych wewnątrz multizbioru
+#define INLINE_WORDS 2
+
+// Największa liczba słów danego typu w multizbiorze
+#define MAX_WORDS UINT32_MAX
+
 /**
  * Główna struktura, na której oparty jest program - multizbiór.
  * Struktura multizbioru przechowująca obiekty różnych typów - tzw. słowa.
+ * Dopóki słów danego typu jest nie więcej niż INLINE_*, są one trzymane
+ * bezpośrednio w strukturze (pole local), a dopiero po przepełnieniu
+ * w tablicy na stercie (pole heap). Pojemność tablicy na stercie wynika
+ * z liczby elementów, dlatego nie jest osobno pamiętana. Tablice local są
+ * na tyle krótkie, by multizbiór nie był większy niż z osobnymi tablicami
+ * na stercie (96 bajtów), więc bez przydziałów obywają się tylko wiersze
+ * z co najwyżej 2 liczbami całkowitymi każdego znaku, 1 liczbą
+ * zmiennoprzecinkową i 2 "nieliczbami". Dłuższe wiersze przydzielają
+ * tablice z areny, jak pokazuje zestawienie bench/alloc_bench.
  * unsigInts - nieujemne liczby całkowite w zbiorze
  * sigInts - ujemne liczby całkowite w zbiorze
  * anyFloats - liczby zmiennoprzecinkowe w zbiorze
  * notNumbers - "nieliczby" w zbiorze
  * size* - ilość elementów poszczególnych typów w zbiorze
- * maxSize* - pamięć przydzielona poszczególnym typom słów
  * lineCount - numer wiersza reprezentowanego przez multizbiór
+ * overflow - czy wiersz ma więcej niż MAX_WORDS słów któregoś typu (takie
+ *            słowa nie są dopisywane, a wiersz jest błędny)
  */
 struct multiset {
-    unsigned long long *unsigInts;
-    long long *sigInts;
-    long double *anyFloats;
-    char **notNumbers;
-    size_t sizeUnsigInts, sizeSigInts, sizeAnyFloats, sizeNotNumbers;
-    size_t maxSizeUnsigInts, maxSizeSigInts, maxSizeAnyFloats, maxSizeNotNumbers;
+    union {
+        unsigned long long local[INLINE_INTS];
+        unsigned long long *heap;
+    } unsigInts;
+    union {
+        long long local[INLINE_INTS];
+        long long *heap;
+    } sigInts;
+    union {
+        long double local[INLINE_FLOATS];
+        long double *heap;
+    } anyFloats;
+    union {
+        char *local[INLINE_WORDS];
+        char **heap;
+    } notNumbers;
+    uint32_t sizeUnsigInts, sizeSigInts, sizeAnyFloats, sizeNotNumbers;
     size_t lineCount;
+    bool overflow;
 };
 typedef struct multiset multiset;
 
+/**
+ * Funkcje zwracające tablice słów poszczególnych typów, niezależnie od tego,
+ * czy leżą one wewnątrz multizbioru, czy na stercie.
+ * x - multizbiór
+ */
+static inline unsigned long long *unsigIntsOf(multiset *x) {
+    return x->sizeUnsigInts <= INLINE_INTS ? x->unsigInts.local
+                                           : x->unsigInts.heap;
+}
+
+static inline long long *sigIntsOf(multiset *x) {
+    return x->sizeSigInts <= INLINE_INTS ? x->sigInts.local : x->sigInts.heap;
+}
+
+static inline long double *anyFloatsOf(multiset *x) {
+    return x->sizeAnyFloats <= INLINE_FLOATS ? x->anyFloats.local
+                                             : x->anyFloats.heap;
+}
+
+static inline char **notNumbersOf(multiset *x) {
+    return x->sizeNotNumbers <= INLINE_WORDS ? x->notNumbers.local
+                                             : x->notNumbers.heap;
+}
+
 #endif //MULTISET_H
@@ -0,0 +1,413 @@
+#include "options.h"
+#include "heavy.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+// Kod wyjścia programu w przypadku błędnych argumentów
+#define USAGE_ERROR 1
+
+// Domyślna liczba wierszy między zapisami punktu kontrolnego
+#define DEFAULT_CHECKPOINT_EVERY 1000000
+
+// Domyślny czas między kolejnymi wypisaniami grup śledzonego pliku
+#define DEFAULT_FOLLOW_INTERVAL 10
+
+// Największa liczba procesów trybu --shards - każdy z nich czyta i parsuje
+// całe dane wejściowe, więc więcej procesów niż rdzeni tylko spowalnia pracę
+#define MAX_SHARDS 64
+
+/**
+ * Funkcja wypisująca sposób użycia programu i kończąca go z błędem.
+ * program - nazwa programu
+ */
+static void usage(const char *program) {
+    fprintf(stderr,
+            "Uzycie: %s [opcje] < dane\n"
+            "  --min-group N  wypisuje tylko grupy z co najmniej N wierszami\n"
+            "  --top K        wypisuje tylko K najwiekszych grup\n"
+            "  --format F     format grup: text (domyslny), binary, jsonl\n"
+            "  --digest       dolacza skroty grup (binary, jsonl)\n"
+            "  --profile-counters\n"
+            "                 wypisuje na stderr liczniki wydajnosci faz\n"
+            "  --case-sensitive  rozroznia wielkosc liter\n"
+            "  --no-octal     liczby z wiodacym zerem sa dziesietne\n"
+            "  --hex-as-word  liczby szesnastkowe sa nieliczbami\n"
+            "  --shards N     dzieli wiersze miedzy N procesow (N <= 64)\n"
+            "  --checkpoint F zapisuje okresowo stan pracy do pliku F\n"
+            "  --checkpoint-every N\n"
+            "                 zapisuje stan co N wierszy (domyslnie 1000000)\n"
+            "  --resume       wznawia prace od stanu zapisanego w pliku F\n"
+            "  --follow F     sledzi wiersze dopisywane do pliku F\n"
+            "  --follow-interval S\n"
+            "                 wypisuje grupy co S sekund (domyslnie 10, 0 - tylko\n"
+            "                 po sygnale SIGUSR1)\n"
+            "  --follow-changes\n"
+            "                 wypisuje tylko zmiany: \"N G\" - wiersz N dolaczyl\n"
+            "                 do grupy o pierwszym wierszu G\n"
+            "  --threads N    parsuje i sortuje wiersze w N watkach\n"
+            "  --sort-threads N\n"
+            "                 sortuje wiersze w N watkach rownolegle z ich\n"
+            "                 parsowaniem w jednym watku (bez --threads)\n"
+            "  --compact      kompaktuje pamiec slow po parsowaniu\n"
+            "  --stats        wypisuje na stderr statystyki pamieci\n"
+            "  --float-epsilon E\n"
+            "                 liczby (takze calkowite) roznice sie o najwyzej E\n"
+            "                 sa rowne\n"
+            "  --float-relative\n"
+            "                 tolerancja E jest wzgledna (0 < E < 1)\n"
+            "  --estimate     szacuje liczbe roznych wierszy w stalej pamieci\n"
+            "  --save-sketch F\n"
+            "                 zapisuje szkic oszacowania do pliku F\n"
+            "  --merge-sketch F\n"
+            "                 dolacza do oszacowania szkic z pliku F\n"
+            "  --heavy-hitters K\n"
+            "                 wypisuje w przyblizeniu K najczestszych grup\n"
+            "                 w stalej pamieci: wiersz, liczba, blad\n"
+            "  --join F       wypisuje wiersze podobne do wierszy pliku F:\n"
+            "                 wiersz, po nim wiersze grupy z pliku F\n"
+            "  --save-index F zapisuje indeks pliku z --join do pliku F\n"
+            "  --load-index F laczy z indeksem zapisanym w pliku F\n"
+            "  --window W     wypisuje na biezaco powtorzenia \"N M\" - wiersz N\n"
+            "                 jest podobny do wiersza M sposrod W ostatnich\n"
+            "  --window-seconds T\n"
+            "                 okno obejmuje wiersze z ostatnich T sekund\n"
+            "  --jaccard T    grupuje wiersze o podobienstwie Jaccarda\n"
+            "                 multizbiorow co najmniej T (0 < T <= 1)\n"
+            "Opcje --join/--load-index, --window/--window-seconds, --follow,\n"
+            "--estimate, --heavy-hitters, --checkpoint i --shards wybieraja\n"
+            "tryby pracy, ktore sie wykluczaja. Opcje --threads,\n"
+            "--sort-threads, --float-epsilon i --jaccard dzialaja tylko\n"
+            "w podstawowym trybie pracy, a opcje --min-group, --top,\n"
+            "--format i --digest nie dzialaja z --join/--load-index,\n"
+            "--window/--window-seconds, --estimate i --heavy-hitters.\n",
+            program);
+    exit(USAGE_ERROR);
+}
+
+/**
+ * Funkcja zamieniająca argument na liczbę nieujemną.
+ * Kończy program z błędem, gdy argument nie jest poprawną liczbą.
+ * program - nazwa programu
+ * arg - argument do zamiany
+ */
+static size_t parseNumber(const char *program, const char *arg) {
+    char *end;
+    unsigned long long x;
+
+    if (arg == NULL || arg[0] < '0' || arg[0] > '9')
+        usage(program);
+
+    errno = 0;
+    x = strtoull(arg, &end, 10);
+
+    if (errno != 0 || *end != '\0' || x > (size_t) -1)
+        usage(program);
+
+    return (size_t) x;
+}
+
+/**
+ * Funkcja zamieniająca argument na liczbę dodatnią.
+ * Kończy program z błędem, gdy argument nie jest poprawną liczbą lub jest
+ * zerem, które wyłączałoby wybierany opcją tryb pracy.
+ * program - nazwa programu
+ * arg - argument do zamiany
+ */
+static size_t parsePositive(const char *program, const char *arg) {
+    size_t x = parseNumber(program, arg);
+
+    if (x == 0)
+        usage(program);
+
+    return x;
+}
+
+/**
+ * Funkcja zamieniająca argument na dodatnią, skończoną tolerancję.
+ * Kończy program z błędem, gdy argument nie jest poprawną liczbą.
+ * program - nazwa programu
+ * arg - argument do zamiany
+ */
+static long double parseEpsilon(const char *program, const char *arg) {
+    char *end;
+    long double x;
+
+    errno = 0;
+    x = strtold(arg, &end);
+
+    if (errno != 0 || end == arg || *end != '\0' || !(x > 0) || isinf(x))
+        usage(program);
+
+    return x;
+}
+
+/**
+ * Funkcja zamieniająca nazwę formatu na format.
+ * Kończy program z błędem, gdy format jest nieznany.
+ * program - nazwa programu
+ * arg - nazwa formatu
+ */
+static format parseFormat(const char *program, const char *arg) {
+    if (strcmp(arg, "text") == 0)
+        return FORMAT_TEXT;
+    else if (strcmp(arg, "binary") == 0)
+        return FORMAT_BINARY;
+    else if (strcmp(arg, "jsonl") == 0)
+        return FORMAT_JSONL;
+
+    usage(program);
+    return FORMAT_TEXT;
+}
+
+/**
+ * Funkcja zapamiętująca kolejny plik ze szkicem. Tablica ma miejsce na
+ * wszystkie argumenty programu, więc jest przydzielana tylko raz.
+ * opts - opcje
+ * path - plik ze szkicem
+ * argc - liczba argumentów programu
+ */
+static void addSketch(options *opts, const char *path, size_t argc) {
+    if (opts->sketches == NULL) {
+        opts->sketches = malloc(argc * sizeof(const char *));
+
+        // Awaryjne wyjście z programu w przypadku braku pamięci
+        if (opts->sketches == NULL)
+            exit(1);
+    }
+
+    opts->sketches[opts->sketchCount++] = path;
+}
+
+/**
+ * Funkcja zwracająca liczbę wybranych trybów pracy innych niż podstawowy:
+ * łączenia z plikiem odniesienia, okna ostatnich wierszy, śledzenia pliku,
+ * szacowania, najczęstszych grup, zapisu stanu i podziału na procesy.
+ * Każdy z tych trybów pomija opcje pozostałych.
+ * opts - opcje programu
+ */
+static int specialModes(const options *opts) {
+    return (opts->join != NULL || opts->loadIndex != NULL)
+           + (opts->window > 0 || opts->windowSeconds > 0)
+           + (opts->follow != NULL) + opts->estimate
+           + (opts->heavyHitters > 0) + (opts->checkpoint != NULL)
+           + (opts->shards > 1);
+}
+
+/**
+ * Funkcja sprawdzająca, czy wybrano tryb pracy, który nie wypisuje grup
+ * przez moduł wypisujący: łączenia z plikiem odniesienia, okna ostatnich
+ * wierszy, szacowania lub najczęstszych grup.
+ * opts - opcje programu
+ */
+static bool ownOutputMode(const options *opts) {
+    return opts->join != NULL || opts->loadIndex != NULL || opts->window > 0
+           || opts->windowSeconds > 0 || opts->estimate
+           || opts->heavyHitters > 0;
+}
+
+/**
+ * Funkcja wczytująca opcje z argumentów programu.
+ * Nieznana opcja, brak jej wartości lub opcja bez działania w wybranym
+ * trybie pracy kończy program z błędem.
+ * opts - opcje do wypełnienia
+ * argc - liczba argumentów
+ * argv - argumenty programu
+ */
+void parseOptions(options *opts, int argc, char *argv[]) {
+    // Opcje, których wartości domyślne nie pozwalają stwierdzić, czy zostały
+    // podane: wypisywania grup, okresu zapisu stanu i śledzenia pliku
+    bool reportGiven = false, everyGiven = false, followGiven = false;
+
+    opts->minGroup = 1;
+    opts->top = 0;
+    opts->form = FORMAT_TEXT;
+    opts->digest = false;
+    opts->profileCounters = false;
+    opts->caseSensitive = false;
+    opts->noOctal = false;
+    opts->hexAsWord = false;
+    opts->shards = 1;
+    opts->checkpoint = NULL;
+    opts->checkpointEvery = DEFAULT_CHECKPOINT_EVERY;
+    opts->resume = false;
+    opts->follow = NULL;
+    opts->followInterval = DEFAULT_FOLLOW_INTERVAL;
+    opts->followChanges = false;
+    opts->threads = 1;
+    opts->sortThreads = 1;
+    opts->compact = false;
+    opts->stats = false;
+    opts->floatEpsilon = 0;
+    opts->floatRelative = false;
+    opts->estimate = false;
+    opts->saveSketch = NULL;
+    opts->sketches = NULL;
+    opts->sketchCount = 0;
+    opts->heavyHitters = 0;
+    opts->join = NULL;
+    opts->saveIndex = NULL;
+    opts->loadIndex = NULL;
+    opts->window = 0;
+    opts->windowSeconds = 0;
+    opts->jaccard = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--min-group") == 0 && i + 1 < argc) {
+            opts->minGroup = parseNumber(argv[0], argv[++i]);
+            reportGiven = true;
+        }
+        else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            opts->top = parseNumber(argv[0], argv[++i]);
+            reportGiven = true;
+        }
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            opts->form = parseFormat(argv[0], argv[++i]);
+            reportGiven = true;
+        }
+        else if (strcmp(argv[i], "--digest") == 0) {
+            opts->digest = true;
+            reportGiven = true;
+        }
+        else if (strcmp(argv[i], "--profile-counters") == 0)
+            opts->profileCounters = true;
+        else if (strcmp(argv[i], "--case-sensitive") == 0)
+            opts->caseSensitive = true;
+        else if (strcmp(argv[i], "--no-octal") == 0)
+            opts->noOctal = true;
+        else if (strcmp(argv[i], "--hex-as-word") == 0)
+            opts->hexAsWord = true;
+        else if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc)
+            opts->shards = parsePositive(argv[0], argv[++i]);
+        else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+            opts->checkpoint = argv[++i];
+        else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+            opts->checkpointEvery = parseNumber(argv[0], argv[++i]);
+            everyGiven = true;
+        }
+        else if (strcmp(argv[i], "--resume") == 0)
+            opts->resume = true;
+        else if (strcmp(argv[i], "--follow") == 0 && i + 1 < argc)
+            opts->follow = argv[++i];
+        else if (strcmp(argv[i], "--follow-interval") == 0 && i + 1 < argc) {
+            opts->followInterval = parseNumber(argv[0], argv[++i]);
+            followGiven = true;
+        }
+        else if (strcmp(argv[i], "--follow-changes") == 0) {
+            opts->followChanges = true;
+            followGiven = true;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            opts->threads = parseNumber(argv[0], argv[++i]);
+        else if (strcmp(argv[i], "--sort-threads") == 0 && i + 1 < argc)
+            opts->sortThreads = parseNumber(argv[0], argv[++i]);
+        else if (strcmp(argv[i], "--compact") == 0)
+            opts->compact = true;
+        else if (strcmp(argv[i], "--stats") == 0)
+            opts->stats = true;
+        else if (strcmp(argv[i], "--float-epsilon") == 0 && i + 1 < argc)
+            opts->floatEpsilon = parseEpsilon(argv[0], argv[++i]);
+        else if (strcmp(argv[i], "--float-relative") == 0)
+            opts->floatRelative = true;
+        else if (strcmp(argv[i], "--estimate") == 0)
+            opts->estimate = true;
+        else if (strcmp(argv[i], "--save-sketch") == 0 && i + 1 < argc)
+            opts->saveSketch = argv[++i];
+        else if (strcmp(argv[i], "--merge-sketch") == 0 && i + 1 < argc)
+            addSketch(opts, argv[++i], (size_t) argc);
+        else if (strcmp(argv[i], "--heavy-hitters") == 0 && i + 1 < argc)
+            opts->heavyHitters = parsePositive(argv[0], argv[++i]);
+        else if (strcmp(argv[i], "--join") == 0 && i + 1 < argc)
+            opts->join = argv[++i];
+        else if (strcmp(argv[i], "--save-index") == 0 && i + 1 < argc)
+            opts->saveIndex = argv[++i];
+        else if (strcmp(argv[i], "--load-index") == 0 && i + 1 < argc)
+            opts->loadIndex = argv[++i];
+        else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc)
+            opts->window = parsePositive(argv[0], argv[++i]);
+        else if (strcmp(argv[i], "--window-seconds") == 0 && i + 1 < argc)
+            opts->windowSeconds = parsePositive(argv[0], argv[++i]);
+        else if (strcmp(argv[i], "--jaccard") == 0 && i + 1 < argc)
+            opts->jaccard = (double) parseEpsilon(argv[0], argv[++i]);
+        else
+            usage(argv[0]);
+    }
+
+    // Można wybrać najwyżej jeden tryb pracy inny niż podstawowy
+    if (specialModes(opts) > 1)
+        usage(argv[0]);
+
+    // Równoległe parsowanie i sortowanie, grupowanie z tolerancją dla liczb
+    // i według podobieństwa Jaccarda działają tylko w podstawowym trybie
+    if (specialModes(opts) > 0
+        && (opts->threads > 1 || opts->sortThreads > 1
+            || opts->floatEpsilon > 0 || opts->jaccard > 0))
+        usage(argv[0]);
+
+    // Tryby z własnym formatem wyników nie korzystają z opcji wypisywania
+    // grup
+    if (reportGiven && ownOutputMode(opts))
+        usage(argv[0]);
+
+    // Wznowić można tylko od stanu zapisanego we wskazanym pliku, a okres
+    // zapisu ma znaczenie tylko przy zapisywaniu stanu
+    if ((opts->resume || everyGiven) && opts->checkpoint == NULL)
+        usage(argv[0]);
+
+    // Opcje śledzenia pliku i szkiców oszacowania wymagają swoich trybów
+    if ((followGiven && opts->follow == NULL)
+        || ((opts->saveSketch != NULL || opts->sketchCount > 0)
+            && !opts->estimate))
+        usage(argv[0]);
+
+    // Indeks buduje się z pliku odniesienia albo odczytuje z pliku, a zapisać
+    // można tylko indeks zbudowany
+    if ((opts->join != NULL && opts->loadIndex != NULL)
+        || (opts->saveIndex != NULL && opts->join == NULL))
+        usage(argv[0]);
+
+    // Każdy proces trybu --shards przegląda całe dane wejściowe
+    if (opts->shards > MAX_SHARDS)
+        usage(argv[0]);
+
+    // Rozmiary tablic podsumowania dla K liczników muszą mieścić się w size_t
+    if (opts->heavyHitters > HEAVY_MAX_COUNTERS)
+        usage(argv[0]);
+
+    // Przy parsowaniu w puli wątków wiersze sortują te same wątki
+    if (opts->sortThreads > 1 && opts->threads > 1)
+        usage(argv[0]);
+
+    // Podobieństwo Jaccarda nie przekracza 1, a grupowanie według niego
+    // nie uwzględnia tolerancji dla liczb
+    if (opts->jaccard > 0 && (opts->jaccard > 1 || opts->floatEpsilon > 0))
+        usage(argv[0]);
+
+    // Tolerancja względna wymaga tolerancji i nie może dopuszczać zmiany
+    // znaku
+    if (opts->floatRelative
+        && (opts->floatEpsilon <= 0 || opts->floatEpsilon >= 1))
+        usage(argv[0]);
+}
+
+/**
+ * Funkcja zwracająca reguły rozpoznawania słów zapisane jako bity.
+ * Stan i indeks zapisane przy innych regułach nie mogą zostać użyte.
+ * opts - opcje programu
+ */
+uint32_t optionsRules(const options *opts) {
+    return (uint32_t) opts->caseSensitive | (uint32_t) opts->noOctal << 1
+           | (uint32_t) opts->hexAsWord << 2;
+}
+
+/**
+ * Funkcja zwalniająca pamięć przydzieloną przy wczytywaniu opcji.
+ * opts - opcje
+ */
+void freeOptions(options *opts) {
+    free(opts->sketches);
+    opts->sketches = NULL;
+    opts->sketchCount = 0;
+}
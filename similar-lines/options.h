@@ -0,0 +1,93 @@
+#include "encoder.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+/**
+ * Opcje programu podane w wierszu poleceń.
+ * minGroup - minimalna liczba wierszy grupy, by została wypisana
+ * top - liczba największych grup do wypisania (0 oznacza wszystkie)
+ * form - format wypisywanych grup
+ * digest - czy wypisywać skróty grup
+ * profileCounters - czy wypisywać liczniki wydajności poszczególnych faz
+ * caseSensitive - czy rozróżniać wielkość liter w słowach
+ * noOctal - czy traktować liczby z wiodącym zerem jako dziesiętne
+ * hexAsWord - czy traktować liczby szesnastkowe jako "nieliczby"
+ * shards - liczba procesów, między które dzielone są wiersze
+ * checkpoint - plik punktu kontrolnego (NULL oznacza brak zapisu stanu)
+ * checkpointEvery - co ile wierszy zapisywać stan (0 - tylko według zegara)
+ * resume - czy wznowić pracę od zapisanego punktu kontrolnego
+ * follow - plik śledzony jak przez tail -f (NULL oznacza standardowe wejście)
+ * followInterval - co ile sekund wypisywać grupy śledzonego pliku
+ * followChanges - czy wypisywać tylko zmiany zamiast wszystkich grup
+ * threads - liczba wątków parsujących i sortujących wiersze
+ * sortThreads - liczba wątków sortujących wiersze parsowane w jednym wątku
+ * compact - czy kompaktować pamięć słów po parsowaniu
+ * stats - czy wypisywać statystyki pamięci
+ * floatEpsilon - tolerancja porównywania liczb zmiennoprzecinkowych
+ *                (0 oznacza porównywanie dokładne)
+ * floatRelative - czy tolerancja jest względna
+ * estimate - czy tylko szacować liczbę różnych multizbiorów
+ * saveSketch - plik, do którego zapisać szkic oszacowania (lub NULL)
+ * sketches - pliki ze szkicami dołączanymi do oszacowania
+ * sketchCount - liczba plików ze szkicami
+ * heavyHitters - liczba najczęstszych grup do wypisania (0 - tryb wyłączony)
+ * join - plik odniesienia, z którym łączone są dane wejściowe (lub NULL)
+ * saveIndex - plik, do którego zapisać indeks pliku odniesienia (lub NULL)
+ * loadIndex - plik z zapisanym indeksem pliku odniesienia (lub NULL)
+ * window - liczba ostatnich wierszy, wśród których szukane są powtórzenia
+ *          (0 - bez ograniczenia liczby wierszy)
+ * windowSeconds - z ilu ostatnich sekund wiersze są w oknie
+ *                 (0 - bez ograniczenia czasu)
+ * jaccard - próg podobieństwa Jaccarda wierszy w grupie
+ *           (0 oznacza porównywanie dokładne)
+ */
+struct options {
+    size_t minGroup;
+    size_t top;
+    format form;
+    bool digest;
+    bool profileCounters;
+    bool caseSensitive;
+    bool noOctal;
+    bool hexAsWord;
+    size_t shards;
+    const char *checkpoint;
+    size_t checkpointEvery;
+    bool resume;
+    const char *follow;
+    size_t followInterval;
+    bool followChanges;
+    size_t threads;
+    size_t sortThreads;
+    bool compact;
+    bool stats;
+    long double floatEpsilon;
+    bool floatRelative;
+    bool estimate;
+    const char *saveSketch;
+    const char **sketches;
+    size_t sketchCount;
+    size_t heavyHitters;
+    const char *join;
+    const char *saveIndex;
+    const char *loadIndex;
+    size_t window;
+    size_t windowSeconds;
+    double jaccard;
+};
+typedef struct options options;
+
+// Funkcja wczytująca opcje z argumentów programu
+extern void parseOptions(options *opts, int argc, char *argv[]);
+
+// Funkcja zwracająca reguły rozpoznawania słów zapisane jako bity
+extern uint32_t optionsRules(const options *opts);
+
+// Funkcja zwalniająca pamięć przydzieloną przy wczytywaniu opcji
+extern void freeOptions(options *opts);
+
+#endif //OPTIONS_H
@@ -1,82 +1,128 @@
-// Flaga potrzebna do poprawnego działania funkcji getline
+// Flaga potrzebna do poprawnego działania funkcji strtok_r
 #define _GNU_SOURCE
 
 #include "parser.h"
 #include "multiset.h"
 #include "recognizer.h"
+#include "reader.h"
+#include "similar.h"
+#include "digest.h"
+#include "pool.h"
 #include <stdlib.h>
 #include <stdbool.h>
-#include <ctype.h>
 #include <string.h>
+#include <unistd.h>
 
-// Stała zwracana przez getline, po wczytaniu ostatniego wiersza
-#define END (-1)
+// Rozmiar danych, po których zebraniu partia wierszy trafia do puli wątków
+#define BATCH_BYTES (1 << 18)
+
+// Maksymalna liczba wierszy w jednej partii
+#define BATCH_LINES 4096
 
 /**
- * Funkcja, która inicjalizuje zadany multizbiór.
- * x - multizbiór, który trzeba zainicjalizować
+ * Wiersz skopiowany do partii.
+ * start - początek wiersza w danych partii
+ * number - numer wiersza danych wejściowych
  */
-static multiset initializeMultiset(multiset x) {
-    x.unsigInts = NULL;
-    x.sigInts = NULL;
-    x.anyFloats = NULL;
-    x.notNumbers = NULL;
-    x.sizeUnsigInts = 0;
-    x.sizeSigInts = 0;
-    x.sizeAnyFloats = 0;
-    x.sizeNotNumbers = 0;
-    x.maxSizeUnsigInts = 0;
-    x.maxSizeSigInts = 0;
-    x.maxSizeAnyFloats = 0;
-    x.maxSizeNotNumbers = 0;
-    x.lineCount = 0;
+struct batchLine {
+    size_t start;
+    size_t number;
+};
+typedef struct batchLine batchLine;
 
-    return x;
-}
+/**
+ * Partia wierszy parsowana przez jedno zadanie puli wątków.
+ * data - skopiowane wiersze, zakończone znakami '\0'
+ * used, reservedData - zajęta i przydzielona pamięć danych
+ * lines - wiersze partii
+ * size, reservedLines - liczba wierszy i pamięć przydzielona tablicy lines
+ * sets - multizbiory wierszy, wypełniane przez zadanie
+ * streamed - czy jedyny wiersz partii został już sparsowany strumieniowo
+ *            i zadanie ma jedynie posortować jego słowa
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ * memories - areny wątków puli
+ * pool - pula wątków
+ */
+struct lineBatch {
+    char *data;
+    size_t used, reservedData;
+    batchLine *lines;
+    size_t size, reservedLines;
+    multiset *sets;
+    bool streamed;
+    wordProcessor process;
+    arena **memories;
+    workerPool *pool;
+};
+typedef struct lineBatch lineBatch;
 
 /**
- * Funckja, która zmienia wszystkie duże litery w tablicy na małe.
- * word - tablica znaków, której duże litery zostaną zmniejszone
- * size - rozmiar dostarczonej tablicy znaków
+ * Stan wiersza parsowanego strumieniowo, fragment po fragmencie.
+ * token - początek słowa przeciętego granicą fragmentów
+ * tokenSize, tokenMax - długość tego początku i pamięć przydzielona na niego
+ * blankLine - czy dotąd sprawdzone znaki są białe
+ * illegal - czy w wierszu wystąpił nielegalny znak
+ * deferred - czy ostatni znak poprzedniego fragmentu czeka na sprawdzenie
+ * last - ten znak
  */
-static char *convertBigLetters(char *word, size_t size) {
-    for (size_t i = 0; i < size; i++) {
-        if (word[i] >= 'A' && word[i] <= 'Z')
-            word[i] = (char) tolower(word[i]);
-    }
+struct lineStream {
+    char *token;
+    size_t tokenSize, tokenMax;
+    bool blankLine;
+    bool illegal;
+    bool deferred;
+    char last;
+};
+typedef struct lineStream lineStream;
 
-    return word;
+/**
+ * Funkcja, która inicjalizuje zadany multizbiór.
+ * Tablice słów nie wymagają inicjalizacji - ich zawartość jest
+ * rozstrzygana na podstawie liczby elementów.
+ * x - multizbiór, który trzeba zainicjalizować
+ */
+static void initializeMultiset(multiset *x) {
+    x->sizeUnsigInts = 0;
+    x->sizeSigInts = 0;
+    x->sizeAnyFloats = 0;
+    x->sizeNotNumbers = 0;
+    x->lineCount = 0;
+    x->overflow = false;
 }
 
 /**
  * Funkcja, która przetwarza cały wiersz w multizbiór.
  * Inicjalizuje nowy multizbiór i z danej linii wyodrębnia wszystkie
- * słowa. Podaje je do przetworzenia, aby rozpoznać ich typy i zwraca
- * kompletny multizbiór, reprezentujący dany wiersz.
+ * słowa. Podaje je do przetworzenia, aby rozpoznać ich typy i umieszcza
+ * je w multizbiorze, reprezentującym dany wiersz.
+ * set - multizbiór, w którym umieszczane są słowa
  * line - wskaźnik przechowujący wszystkie znaki z wiersza
  * count - numer wiersza z danych wejściowych
+ * memory - arena, w której przydzielana jest pamięć na słowa
+ * process - funkcja przetwarzająca słowa według wybranych reguł
  */
-static multiset createMultiset(char *line, size_t count) {
+static void createMultiset(multiset *set, char *line, size_t count,
+                           arena *memory, wordProcessor process) {
     size_t wordSize;
-    multiset set = initializeMultiset(set);
+    initializeMultiset(set);
 
-    // Białe znaki, dziękim którym funkcja strtok wie, jak wyodrębniać słowa
+    // Białe znaki, dziękim którym funkcja strtok_r wie, jak wyodrębniać słowa
     char *whitespaces = " \t\n\v\f\r";
-    // Funkcja strtok wyodrębnia podciągi z danego ciągu
-    char *word = strtok(line, whitespaces);
+    // Stan funkcji strtok_r - wiersze mogą być parsowane przez wiele wątków
+    char *state;
+    // Funkcja strtok_r wyodrębnia podciągi z danego ciągu
+    char *word = strtok_r(line, whitespaces, &state);
 
     while (word != NULL) {
         wordSize = strlen(word);
-        word = convertBigLetters(word, wordSize);
         // Funkcja przetwarzająca słowa - główna funkcja modułu "recognizer.h"
-        set = processWord(set, word, wordSize);
+        process(set, word, wordSize, memory);
 
         // Aby funkcja szukała następnego słowa od ostatniego zakończenia
-        word = strtok(NULL, whitespaces);
+        word = strtok_r(NULL, whitespaces, &state);
     }
 
-    set.lineCount = count;
-    return set;
+    set->lineCount = count;
 }
 
 /**
@@ -110,8 +156,10 @@ static bool isIllegalSign(char x) {
  * line - wskaźnik przechowujący wszystkie znaki z wiersza.
  * size - liczba znaków w wierszu
  * count - numer wiersza
+ * reportErrors - czy wypisywać komunikat o błędnym znaku
  */
-static bool ignoreLine(char *line, size_t size, size_t count) {
+static bool ignoreLine(char *line, size_t size, size_t count,
+                       bool reportErrors) {
     size_t i;
     bool blankLine = true;
 
@@ -123,7 +171,8 @@ static bool ignoreLine(char *line, size_t size, size_t count) {
         for (i = 0; i < size; i++) {
             if (isIllegalSign(line[i])) {
                 // Komunikat o błędnym znaku na wyjście diagnostyczne
-                fprintf(stderr, "ERROR %zu\n", count);
+                if (reportErrors)
+                    fprintf(stderr, "ERROR %zu\n", count);
                 return true;
             }
             
@@ -136,57 +185,589 @@ static bool ignoreLine(char *line, size_t size, size_t count) {
     return blankLine;
 }
 
+/**
+ * Funkcja sprawdzająca kolejny znak wiersza parsowanego strumieniowo.
+ * s - stan wiersza
+ * x - znak do sprawdzenia
+ */
+static void checkSign(lineStream *s, char x) {
+    if (isIllegalSign(x))
+        s->illegal = true;
+    else if (s->blankLine && !isWhitespace(x))
+        s->blankLine = false;
+}
+
+/**
+ * Funkcja sprawdzająca znaki fragmentu wiersza tak jak ignoreLine.
+ * Tak jak tam, ostatni znak wiersza bez '\n' na końcu danych nie jest
+ * sprawdzany, dlatego ostatni znak fragmentu, który nie kończy wiersza,
+ * jest sprawdzany dopiero wtedy, gdy wiersz okaże się dłuższy. Zwraca liczbę
+ * białych znaków na początku fragmentu wiersza, który dotąd był pusty - tych
+ * znaków nie trzeba już przeglądać w poszukiwaniu słów.
+ * s - stan wiersza
+ * part - znaki fragmentu
+ * length - liczba znaków fragmentu (bez znaku nowej linii)
+ * whole - czy fragment kończy wiersz
+ * newline - czy fragment kończy się znakiem nowej linii
+ */
+static size_t checkPart(lineStream *s, const char *part, size_t length,
+                        bool whole, bool newline) {
+    size_t checked = whole ? length : length - 1, i = 0, skipped = 0;
+
+    if (s->deferred && (length > 0 || newline))
+        checkSign(s, s->last);
+
+    s->deferred = false;
+
+    if (s->blankLine) {
+        while (i < checked && isWhitespace(part[i]))
+            i++;
+
+        skipped = i;
+        s->blankLine = i == checked;
+    }
+
+    // Gdy wiersz już nie jest pusty, wystarczy szukać nielegalnych znaków
+    for (; i < checked && !s->illegal; i++) {
+        if (isIllegalSign(part[i]))
+            s->illegal = true;
+    }
+
+    if (!whole) {
+        s->deferred = true;
+        s->last = part[length - 1];
+    }
+
+    return skipped;
+}
+
+/**
+ * Funkcja dopisująca znaki do początku słowa przeciętego granicą fragmentów.
+ * s - stan wiersza
+ * data - dopisywane znaki
+ * size - liczba dopisywanych znaków
+ */
+static void appendToken(lineStream *s, const char *data, size_t size) {
+    if (s->tokenSize + size + 1 > s->tokenMax) {
+        s->tokenMax = 2 * (s->tokenSize + size + 1);
+        s->token = realloc(s->token, s->tokenMax);
+
+        // Awaryjne wyjście z programu w przypadku braku pamięci
+        if (s->token == NULL)
+            exit(1);
+    }
+
+    memcpy(s->token + s->tokenSize, data, size);
+    s->tokenSize += size;
+}
+
+/**
+ * Funkcja wyodrębniająca słowa z fragmentu wiersza i przetwarzająca je.
+ * Słowa leżące w całości we fragmencie są przetwarzane w miejscu, po
+ * zastąpieniu następującego po nich białego znaku znakiem '\0', tak jak robi
+ * to strtok. Jedynie słowo przecięte granicą fragmentów jest kopiowane.
+ * s - stan wiersza
+ * set - multizbiór, w którym umieszczane są słowa
+ * part - znaki fragmentu
+ * length - liczba znaków fragmentu (bez znaku nowej linii)
+ * whole - czy fragment kończy wiersz
+ * p - parser
+ */
+static void tokenizePart(lineStream *s, multiset *set, char *part,
+                         size_t length, bool whole, parser *p) {
+    size_t i = 0, start;
+
+    while (i < length) {
+        start = i;
+
+        while (i < length && !isWhitespace(part[i]))
+            i++;
+
+        if (i == length && !whole) {
+            // Słowo może ciągnąć się w kolejnym fragmencie
+            appendToken(s, part + start, i - start);
+            return;
+        }
+
+        if (s->tokenSize > 0) {
+            appendToken(s, part + start, i - start);
+            s->token[s->tokenSize] = '\0';
+            p->process(set, s->token, s->tokenSize, p->memory);
+            s->tokenSize = 0;
+        }
+        else if (i > start) {
+            // Po słowie jest biały znak albo zastąpiony znak nowej linii
+            part[i] = '\0';
+            p->process(set, part + start, i - start, p->memory);
+        }
+
+        // Pierwszy znak po słowie mógł zostać zastąpiony znakiem '\0'
+        i++;
+
+        while (i < length && isWhitespace(part[i]))
+            i++;
+    }
+
+    if (whole && s->tokenSize > 0) {
+        s->token[s->tokenSize] = '\0';
+        p->process(set, s->token, s->tokenSize, p->memory);
+        s->tokenSize = 0;
+    }
+}
+
+/**
+ * Funkcja pomijająca resztę wiersza bez przeglądania jego znaków.
+ * p - parser
+ */
+static void skipRest(parser *p) {
+    bool whole = false;
+    ssize_t read;
+    char *part;
+
+    while (!whole && (read = readerGetPart(p->reader, &part, &whole)) >= 0)
+        p->offset += read;
+}
+
+/**
+ * Funkcja parsująca wiersz, który nie mieści się w jednym buforze czytnika.
+ * Zamiast sklejać cały wiersz w pamięci, sprawdza znaki i wyodrębnia słowa
+ * kolejnych fragmentów w miarę ich napływania, więc poza słowami multizbioru
+ * zajmuje pamięć rzędu najdłuższego słowa. Wiersz, który trzeba ignorować,
+ * jest porzucany od razu - reszta jest jedynie pomijana, a słowa przetworzone
+ * przed nielegalnym znakiem są zwalniane z areny. Zwraca prawdę, gdy wiersz
+ * nie jest ignorowany.
+ * p - parser
+ * set - multizbiór, w którym umieszczane są słowa wiersza
+ * part - pierwszy fragment wiersza
+ * size - długość pierwszego fragmentu
+ */
+static bool streamLine(parser *p, multiset *set, char *part, size_t size) {
+    arenaMark mark = arenaGetMark(p->memory);
+    lineStream s = {NULL, 0, 0, true, false, false, '\0'};
+    bool whole = false, newline;
+    size_t length, skipped;
+    ssize_t read;
+
+    // Komentarz nie jest sprawdzany ani parsowany
+    if (part[0] == '#') {
+        skipRest(p);
+        return false;
+    }
+
+    initializeMultiset(set);
+
+    while (true) {
+        newline = whole && size > 0;
+        length = newline ? size - 1 : size;
+        skipped = checkPart(&s, part, length, whole, newline);
+
+        if (s.illegal)
+            break;
+
+        tokenizePart(&s, set, part + skipped, length - skipped, whole, p);
+
+        // Wiersz ze zbyt wieloma słowami jednego typu jest błędny
+        if (set->overflow) {
+            s.illegal = true;
+            break;
+        }
+
+        if (whole)
+            break;
+
+        read = readerGetPart(p->reader, &part, &whole);
+        p->offset += read;
+        size = (size_t) read;
+    }
+
+    free(s.token);
+
+    if (s.illegal) {
+        // Komunikat o błędnym znaku na wyjście diagnostyczne
+        if (p->reportErrors)
+            fprintf(stderr, "ERROR %zu\n", p->count);
+
+        if (!whole)
+            skipRest(p);
+    }
+
+    if (s.illegal || s.blankLine) {
+        arenaRelease(p->memory, mark);
+        return false;
+    }
+
+    set->lineCount = p->count;
+    return true;
+}
+
+/**
+ * Funkcja przygotowująca parser wierszy.
+ * p - parser
+ * reader - czytnik, z którego pobierane są wiersze
+ * memory - arena, w której przydzielana jest pamięć na słowa
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ * reportErrors - czy wypisywać komunikaty o wierszach z błędnymi znakami
+ */
+void parserInit(parser *p, lineReader *reader, arena *memory,
+                wordProcessor process, bool reportErrors) {
+    p->reader = reader;
+    // Wiersze są numerowane od 1
+    p->count = 1;
+    p->offset = 0;
+    p->memory = memory;
+    p->process = process;
+    p->reportErrors = reportErrors;
+}
+
+/**
+ * Funkcja parsująca kolejny nieignorowany wiersz w multizbiór.
+ * Ignorowane wiersze są pomijane, ale również numerowane. Zwraca fałsz,
+ * gdy dane wejściowe się skończyły, a przy czytniku śledzącym plik także
+ * wtedy, gdy kolejny pełny wiersz jeszcze nie został dopisany.
+ * p - parser
+ * set - multizbiór, w którym umieszczane są słowa wiersza
+ */
+bool parseLine(parser *p, multiset *set) {
+    arenaMark mark;
+    char *line;
+    ssize_t read;
+    bool whole;
+
+    while ((read = readerGetPart(p->reader, &line, &whole)) >= 0) {
+        p->offset += read;
+
+        // Wiersz rozciągający się na kilka buforów czytnika
+        if (!whole) {
+            if (streamLine(p, set, line, (size_t) read)) {
+                p->count++;
+                return true;
+            }
+        }
+        // Ignorowane linie nie są przetwarzane. Czytnik zwraca długość linii
+        // zbyt dużą o jeden - odpowiednia korekta.
+        else if (!ignoreLine(line, read - 1, p->count, p->reportErrors)) {
+            mark = arenaGetMark(p->memory);
+            createMultiset(set, line, p->count, p->memory, p->process);
+
+            if (!set->overflow) {
+                p->count++;
+                return true;
+            }
+
+            // Wiersz sklejony w trybie śledzenia może mieć zbyt wiele słów
+            if (p->reportErrors)
+                fprintf(stderr, "ERROR %zu\n", p->count);
+
+            arenaRelease(p->memory, mark);
+        }
+
+        p->count++;
+    }
+
+    return false;
+}
+
+/**
+ * Funkcja parsująca kolejny nieignorowany wiersz i zwracająca skrót jego
+ * posortowanego multizbioru. Pamięć wiersza jest od razu zwalniana, więc
+ * przetwarzanie dowolnie długiego strumienia zajmuje stałą pamięć. Zwraca
+ * fałsz, gdy dane wejściowe się skończyły.
+ * p - parser
+ * digest - miejsce na skrót multizbioru
+ * number - miejsce na numer wiersza
+ */
+bool parseDigest(parser *p, uint64_t *digest, size_t *number) {
+    arenaMark mark = arenaGetMark(p->memory);
+    multiset set;
+
+    if (!parseLine(p, &set))
+        return false;
+
+    sortMultiset(&set);
+    *digest = multisetDigest(&set);
+    *number = set.lineCount;
+    arenaRelease(p->memory, mark);
+    return true;
+}
+
 /**
  * Funkcja parsujące dane wejściowe.
- * Pobiera kolejne linie z danych wejściowych przy pomocy getline, wyodrębnia
- * z legalnych słowa, które przetwarza i zwraca zebrane w multizbiorze.
+ * Pobiera kolejne linie z danych wejściowych przy pomocy czytnika, którego
+ * osobny wątek wczytuje dane w czasie parsowania wcześniejszych wierszy.
+ * Wyodrębnia z legalnych linii słowa, które przetwarza i zwraca zebrane
+ * w multizbiorze. Sparsowane wiersze od razu trafiają do etapu sortowania,
+ * więc sortowanie przebiega równolegle z parsowaniem dalszych wierszy.
+ * Przed powiększeniem tablicy multizbiorów parser czeka na posortowanie
+ * przekazanych wierszy, bo tablica może zostać przeniesiona.
  * text - wskaźnik na multizbiory reprezentujące kolejne linie tekstu
  * currentSize - obecna liczba multizbiorów wskazywanych przez wskaźnik text
+ * memory - arena, w której przydzielana jest pamięć na słowa
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ * sortThreads - liczba wątków sortujących wiersze
  */
-multiset *loadInput(multiset *text, size_t *currentSize) {
-    char *line = NULL;
-    size_t reservedSize, buffSize, count;
-    ssize_t read;
+multiset *loadInput(multiset *text, size_t *currentSize, arena *memory,
+                    wordProcessor process, size_t sortThreads) {
+    size_t reservedSize = DEFAULT_SIZE;
+    lineReader *reader = readerCreate(STDIN_FILENO);
+    sortStage stage;
+    parser p;
 
-    // Wiersze są numerowane od 1
-    count = 1;
-    reservedSize = DEFAULT_SIZE;
+    parserInit(&p, reader, memory, process, true);
+    sortStageInit(&stage, sortThreads);
     *currentSize = 0;
 
-    while ((read = getline(&line, &buffSize, stdin)) != END) {
+    while (true) {
+        if (*currentSize >= reservedSize)
+            sortStageWait(&stage);
+
         text = expand(text, sizeof(multiset), *currentSize, &reservedSize);
 
-        // Ignorowane linie nie są przetwarzane. Getline zwraca długość linii
-        // zbyt dużą o jeden - odpowiednia korekta.
-        if (!ignoreLine(line, read - 1, count)) {
-            text[*currentSize] = createMultiset(line, count);
-            ++*currentSize;
-        }
+        if (!parseLine(&p, &text[*currentSize]))
+            break;
 
-        // Ignorowane wiersze również są numerowane
-        count++;
+        sortStageAdd(&stage, text, ++*currentSize);
     }
 
-    free(line);
+    readerDestroy(reader);
+    sortStageFinish(&stage, text, *currentSize);
+    tokenCacheFlush();
     return text;
 }
 
 /**
- * Funkcja zwalniająca pamięć po danym multizbiorze.
- * x - multizbiór, z którego chcemy zwolnić pamięć.
+ * Funkcja tworząca pustą partię wierszy.
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ * memories - areny wątków puli
+ * pool - pula wątków
+ */
+static lineBatch *createBatch(wordProcessor process, arena **memories,
+                              workerPool *pool) {
+    lineBatch *b = malloc(sizeof(lineBatch));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (b == NULL)
+        exit(1);
+
+    b->data = NULL;
+    b->used = 0;
+    b->reservedData = 0;
+    b->lines = NULL;
+    b->size = 0;
+    b->reservedLines = 0;
+    b->sets = NULL;
+    b->streamed = false;
+    b->process = process;
+    b->memories = memories;
+    b->pool = pool;
+    return b;
+}
+
+/**
+ * Funkcja tworząca partię z jednym wierszem już sparsowanym strumieniowo,
+ * której zadanie jedynie sortuje słowa.
+ * set - multizbiór wiersza
+ * memories - areny wątków puli
+ * pool - pula wątków
  */
-void freeMultiset(multiset *x) {
-    for (size_t i = 0; i < (*x).sizeNotNumbers; i++) {
-        if ((*x).notNumbers[i] != NULL)
-            free((*x).notNumbers[i]);
+static lineBatch *createStreamedBatch(const multiset *set, arena **memories,
+                                      workerPool *pool) {
+    lineBatch *b = createBatch(NULL, memories, pool);
+
+    b->sets = malloc(sizeof(multiset));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (b->sets == NULL)
+        exit(1);
+
+    b->sets[0] = *set;
+    b->size = 1;
+    b->streamed = true;
+    return b;
+}
+
+/**
+ * Funkcja kopiująca wiersz do partii.
+ * b - partia
+ * line - wiersz zakończony znakiem '\0'
+ * length - długość wiersza
+ * number - numer wiersza
+ */
+static void appendBatchLine(lineBatch *b, const char *line, size_t length,
+                            size_t number) {
+    if (b->used + length + 1 > b->reservedData) {
+        b->reservedData = 2 * (b->used + length + 1);
+        b->data = realloc(b->data, b->reservedData);
+
+        // Awaryjne wyjście z programu w przypadku braku pamięci
+        if (b->data == NULL)
+            exit(1);
     }
 
-    if ((*x).notNumbers != NULL)
-        free((*x).notNumbers);
-    if ((*x).unsigInts != NULL)
-        free((*x).unsigInts);
-    if ((*x).sigInts != NULL)
-        free((*x).sigInts);
-    if ((*x).anyFloats != NULL)
-        free((*x).anyFloats);
+    b->lines = expand(b->lines, sizeof(batchLine), b->size, &b->reservedLines);
+    b->lines[b->size].start = b->used;
+    b->lines[b->size++].number = number;
+    memcpy(b->data + b->used, line, length + 1);
+    b->used += length + 1;
+}
+
+/**
+ * Zadanie puli parsujące partię wierszy w multizbiory w arenie swojego
+ * wątku i sortujące ich słowa - duże tablice w osobnych zadaniach.
+ * arg - partia
+ * worker - numer wątku puli
+ */
+static void parseBatchTask(void *arg, size_t worker) {
+    lineBatch *b = arg;
+
+    for (size_t i = 0; i < b->size; i++) {
+        if (!b->streamed)
+            createMultiset(&b->sets[i], b->data + b->lines[i].start,
+                           b->lines[i].number, b->memories[worker],
+                           b->process);
+
+        sortMultisetTasks(&b->sets[i], b->pool, worker);
+    }
+
+    tokenCacheFlush();
+}
+
+/**
+ * Funkcja przekazująca partię do sparsowania przez pulę wątków
+ * i zapamiętująca ją do sklejenia wyników.
+ * b - partia
+ * batches - wszystkie przekazane partie
+ * batchCount - liczba przekazanych partii
+ * reservedBatches - pamięć przydzielona tablicy batches
+ */
+static lineBatch **submitBatch(lineBatch *b, lineBatch **batches,
+                               size_t *batchCount, size_t *reservedBatches) {
+    if (!b->streamed) {
+        b->sets = malloc(b->size * sizeof(multiset));
+
+        // Awaryjne wyjście z programu w przypadku braku pamięci
+        if (b->sets == NULL)
+            exit(1);
+    }
+
+    batches = expand(batches, sizeof(lineBatch *), *batchCount,
+                     reservedBatches);
+    batches[(*batchCount)++] = b;
+    poolSubmit(b->pool, POOL_EXTERNAL, parseBatchTask, b);
+    return batches;
+}
+
+/**
+ * Funkcja parsująca dane wejściowe w puli wątków.
+ * Wątek główny pobiera wiersze z czytnika, odrzuca ignorowane wiersze
+ * (wypisując komunikaty o błędach w kolejności wierszy) i kopiuje pozostałe
+ * do partii o rozmiarze około BATCH_BYTES. Bardzo długi wiersz tworzy
+ * osobną partię, a jego duże tablice słów są sortowane we fragmentach przez
+ * wiele wątków. Wiersz dłuższy niż bufor czytnika parsuje strumieniowo sam
+ * wątek główny, w arenie memory. Zwraca multizbiory w kolejności wierszy, już posortowane,
+ * a areny wątków przejmuje arena memory.
+ * text - wskaźnik na multizbiory reprezentujące kolejne linie tekstu
+ * currentSize - obecna liczba multizbiorów wskazywanych przez wskaźnik text
+ * memory - arena, która przejmuje pamięć słów
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ * threads - liczba wątków puli
+ */
+multiset *loadInputParallel(multiset *text, size_t *currentSize, arena *memory,
+                            wordProcessor process, size_t threads) {
+    lineReader *reader = readerCreate(STDIN_FILENO);
+    workerPool *pool = poolCreate(threads);
+    arena **memories = malloc(threads * sizeof(arena *));
+    size_t batchCount = 0, reservedBatches = DEFAULT_SIZE, length;
+    lineBatch **batches = malloc(reservedBatches * sizeof(lineBatch *));
+    lineBatch *current = NULL;
+    multiset set;
+    ssize_t read;
+    bool whole;
+    char *line;
+    parser p;
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (memories == NULL || batches == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < threads; i++)
+        memories[i] = arenaCreate();
+
+    parserInit(&p, reader, memory, process, true);
+
+    while ((read = readerGetPart(reader, &line, &whole)) >= 0) {
+        // Wiersz rozciągający się na kilka buforów czytnika jest parsowany
+        // strumieniowo przez wątek główny, a pula jedynie sortuje jego słowa
+        if (!whole) {
+            if (current != NULL) {
+                batches = submitBatch(current, batches, &batchCount,
+                                      &reservedBatches);
+                current = NULL;
+            }
+
+            if (streamLine(&p, &set, line, (size_t) read)) {
+                batches = submitBatch(createStreamedBatch(&set, memories,
+                                                          pool),
+                                      batches, &batchCount, &reservedBatches);
+            }
+        }
+        else if (!ignoreLine(line, read - 1, p.count, true)) {
+            length = strlen(line);
+
+            // Bardzo długi wiersz nie czeka w jednym zadaniu na krótkie
+            if (current != NULL && length >= BATCH_BYTES) {
+                batches = submitBatch(current, batches, &batchCount,
+                                      &reservedBatches);
+                current = NULL;
+            }
+
+            if (current == NULL)
+                current = createBatch(process, memories, pool);
+
+            appendBatchLine(current, line, length, p.count);
+
+            if (current->used >= BATCH_BYTES || current->size >= BATCH_LINES) {
+                batches = submitBatch(current, batches, &batchCount,
+                                      &reservedBatches);
+                current = NULL;
+            }
+        }
+
+        p.count++;
+    }
+
+    if (current != NULL)
+        batches = submitBatch(current, batches, &batchCount, &reservedBatches);
+
+    readerDestroy(reader);
+    tokenCacheFlush();
+    poolWait(pool);
+    poolDestroy(pool);
+
+    // Sklejanie wyników partii w kolejności wierszy
+    *currentSize = 0;
+
+    for (size_t i = 0; i < batchCount; i++)
+        *currentSize += batches[i]->size;
+
+    text = realloc(text, (*currentSize + 1) * sizeof(multiset));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (text == NULL)
+        exit(1);
+
+    for (size_t i = 0, j = 0; i < batchCount; i++) {
+        memcpy(&text[j], batches[i]->sets, batches[i]->size * sizeof(multiset));
+        j += batches[i]->size;
+        free(batches[i]->data);
+        free(batches[i]->lines);
+        free(batches[i]->sets);
+        free(batches[i]);
+    }
+
+    for (size_t i = 0; i < threads; i++)
+        arenaAdopt(memory, memories[i]);
+
+    free(memories);
+    free(batches);
+    return text;
 }
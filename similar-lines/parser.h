@@ -1,4 +1,10 @@
 #include "multiset.h"
+#include "arena.h"
+#include "recognizer.h"
+#include "reader.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
 
 #ifndef INPUT_H
 #define INPUT_H
@@ -6,11 +12,46 @@
 // Początkowy rozmiar przydzielanej wolnej pamięci
 #define DEFAULT_SIZE 32
 
+/**
+ * Parser pobierający wiersze z czytnika i przetwarzający je w multizbiory.
+ * reader - czytnik, z którego pobierane są wiersze
+ * count - numer następnego wiersza danych wejściowych
+ * offset - liczba bajtów danych wejściowych pobranych z czytnika
+ * memory - arena, w której przydzielana jest pamięć na słowa
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ * reportErrors - czy wypisywać komunikaty o wierszach z błędnymi znakami
+ */
+struct parser {
+    lineReader *reader;
+    size_t count;
+    off_t offset;
+    arena *memory;
+    wordProcessor process;
+    bool reportErrors;
+};
+typedef struct parser parser;
+
+// Funkcja przygotowująca parser wierszy z danego czytnika
+extern void parserInit(parser *p, lineReader *reader, arena *memory,
+                       wordProcessor process, bool reportErrors);
+
+// Funkcja parsująca kolejny nieignorowany wiersz w multizbiór
+extern bool parseLine(parser *p, multiset *set);
+
+// Funkcja parsująca kolejny nieignorowany wiersz w skrót jego multizbioru,
+// bez zatrzymywania pamięci wiersza
+extern bool parseDigest(parser *p, uint64_t *digest, size_t *number);
+
 // Funkcja parsująca dane wejściowe i odpowiednio przetwarzająca wiersze
-// w tablicę multizbiorów, dynamicznie przydzielając wolną pamięć
-extern multiset *loadInput(multiset *text, size_t *currentSize);
+// w tablicę multizbiorów, przydzielając pamięć na słowa z areny, i sortująca
+// je w sortThreads wątkach równolegle z parsowaniem
+extern multiset *loadInput(multiset *text, size_t *currentSize, arena *memory,
+                           wordProcessor process, size_t sortThreads);
 
-// Funkcja zwalniająca pamięć po wszystkich multizbiorach
-extern void freeMultiset(multiset *x);
+// Funkcja parsująca dane wejściowe w puli threads wątków, zwracająca
+// multizbiory z już posortowanymi słowami
+extern multiset *loadInputParallel(multiset *text, size_t *currentSize,
+                                   arena *memory, wordProcessor process,
+                                   size_t threads);
 
 #endif //INPUT_H
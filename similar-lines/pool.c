@@ -0,0 +1,232 @@
+// Flaga potrzebna do poprawnego działania funkcji nanosleep
+#define _GNU_SOURCE
+
+#include "pool.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <sched.h>
+#include <time.h>
+
+// Liczba prób oddania procesora przed krótkim uśpieniem wątku
+#define SPIN_LIMIT 64
+
+// Czas uśpienia wątku, który nie znalazł żadnego zadania (w nanosekundach)
+#define BACKOFF_NS 50000
+
+/**
+ * Funkcja, w której wątek czeka na pojawienie się zadań.
+ * Najpierw oddaje procesor, a po wielu nieudanych próbach krótko zasypia.
+ * spins - liczba dotychczasowych prób czekania
+ */
+static void backoff(size_t *spins) {
+    if (*spins < SPIN_LIMIT) {
+        sched_yield();
+        ++*spins;
+    }
+    else {
+        struct timespec pause = {0, BACKOFF_NS};
+        nanosleep(&pause, NULL);
+    }
+}
+
+/**
+ * Funkcja dokładająca zadanie na koniec kolejki, powiększając ją w razie
+ * potrzeby.
+ * d - kolejka
+ * t - zadanie
+ */
+static void pushTask(taskDeque *d, task t) {
+    pthread_mutex_lock(&d->lock);
+
+    if (d->tail - d->head == d->capacity) {
+        task *items = malloc(2 * d->capacity * sizeof(task));
+
+        // Awaryjne wyjście z programu w przypadku braku pamięci
+        if (items == NULL)
+            exit(1);
+
+        for (size_t i = d->head; i < d->tail; i++)
+            items[i & (2 * d->capacity - 1)] = d->items[i & (d->capacity - 1)];
+
+        free(d->items);
+        d->items = items;
+        d->capacity *= 2;
+    }
+
+    d->items[d->tail++ & (d->capacity - 1)] = t;
+    pthread_mutex_unlock(&d->lock);
+}
+
+/**
+ * Funkcja zdejmująca zadanie z kolejki - właściciel bierze ostatnio
+ * dołożone zadanie (dane są jeszcze w jego pamięci podręcznej), a złodziej
+ * najstarsze. Zwraca fałsz, gdy kolejka jest pusta.
+ * d - kolejka
+ * t - miejsce na zadanie
+ * owner - czy zadanie bierze właściciel kolejki
+ */
+static bool takeTask(taskDeque *d, task *t, bool owner) {
+    bool found = false;
+
+    pthread_mutex_lock(&d->lock);
+
+    if (d->tail > d->head) {
+        if (owner)
+            *t = d->items[--d->tail & (d->capacity - 1)];
+        else
+            *t = d->items[d->head++ & (d->capacity - 1)];
+
+        found = true;
+    }
+
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+/**
+ * Funkcja losująca numer wątku do okradzenia (xorshift).
+ * state - stan generatora
+ */
+static uint64_t nextRandom(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+ * Główna funkcja wątku puli. Wykonuje zadania z własnej kolejki, a gdy jej
+ * zabraknie, próbuje ukraść zadanie kolejno ze wszystkich innych kolejek,
+ * zaczynając od losowej.
+ * arg - dane wątku
+ */
+static void *work(void *arg) {
+    poolWorker *self = arg;
+    workerPool *pool = self->pool;
+    uint64_t state = 0x9e3779b97f4a7c15ULL * (self->index + 1);
+    size_t spins = 0, victim;
+    bool found;
+    task t;
+
+    while (true) {
+        found = takeTask(&pool->deques[self->index], &t, true);
+
+        for (size_t i = 1; !found && i < pool->size; i++) {
+            victim = (size_t) (nextRandom(&state) % pool->size);
+
+            if (victim != self->index)
+                found = takeTask(&pool->deques[victim], &t, false);
+        }
+
+        if (found) {
+            t.run(t.arg, self->index);
+            atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_release);
+            spins = 0;
+        }
+        else if (atomic_load_explicit(&pool->stop, memory_order_relaxed)) {
+            return NULL;
+        }
+        else {
+            backoff(&spins);
+        }
+    }
+}
+
+/**
+ * Funkcja tworząca pulę wątków.
+ * size - liczba wątków
+ */
+workerPool *poolCreate(size_t size) {
+    workerPool *pool = malloc(sizeof(workerPool));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (pool == NULL)
+        exit(1);
+
+    pool->size = size;
+    pool->workers = malloc(size * sizeof(poolWorker));
+    pool->deques = malloc(size * sizeof(taskDeque));
+    atomic_init(&pool->pending, 0);
+    atomic_init(&pool->next, 0);
+    atomic_init(&pool->stop, false);
+
+    if (pool->workers == NULL || pool->deques == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < size; i++) {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+        pool->deques[i].items = malloc(POOL_DEQUE_SIZE * sizeof(task));
+        pool->deques[i].head = 0;
+        pool->deques[i].tail = 0;
+        pool->deques[i].capacity = POOL_DEQUE_SIZE;
+
+        if (pool->deques[i].items == NULL)
+            exit(1);
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+
+        if (pthread_create(&pool->workers[i].thread, NULL, work,
+                           &pool->workers[i]) != 0)
+            exit(1);
+    }
+
+    return pool;
+}
+
+/**
+ * Funkcja zlecająca zadanie. Wątek puli dokłada je do własnej kolejki,
+ * a zadania spoza puli są rozdzielane między kolejki po kolei.
+ * pool - pula
+ * worker - numer zlecającego wątku puli albo POOL_EXTERNAL
+ * run - funkcja wykonująca zadanie
+ * arg - argument funkcji
+ */
+void poolSubmit(workerPool *pool, size_t worker, taskFunction run,
+                void *arg) {
+    task t = {run, arg};
+
+    if (worker == POOL_EXTERNAL)
+        worker = atomic_fetch_add_explicit(&pool->next, 1,
+                                           memory_order_relaxed) % pool->size;
+
+    // Licznik jest zwiększany przed dołożeniem zadania, aby poolWait nie
+    // zakończył się, zanim zadanie zlecone przez inne zadanie się wykona
+    atomic_fetch_add_explicit(&pool->pending, 1, memory_order_relaxed);
+    pushTask(&pool->deques[worker], t);
+}
+
+/**
+ * Funkcja czekająca na zakończenie wszystkich zleconych zadań, także tych
+ * zleconych w trakcie czekania przez inne zadania.
+ * pool - pula
+ */
+void poolWait(workerPool *pool) {
+    size_t spins = 0;
+
+    while (atomic_load_explicit(&pool->pending, memory_order_acquire) > 0)
+        backoff(&spins);
+}
+
+/**
+ * Funkcja kończąca pracę wątków puli i zwalniająca jej pamięć. Zlecone
+ * zadania muszą być wcześniej zakończone.
+ * pool - pula
+ */
+void poolDestroy(workerPool *pool) {
+    atomic_store_explicit(&pool->stop, true, memory_order_relaxed);
+
+    for (size_t i = 0; i < pool->size; i++)
+        pthread_join(pool->workers[i].thread, NULL);
+
+    for (size_t i = 0; i < pool->size; i++) {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].items);
+    }
+
+    free(pool->workers);
+    free(pool->deques);
+    free(pool);
+}
@@ -0,0 +1,95 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#ifndef POOL_H
+#define POOL_H
+
+// Początkowa liczba zadań mieszczących się w kolejce jednego wątku
+#define POOL_DEQUE_SIZE 256
+
+// Numer wątku zlecającego zadania spoza puli (np. wątku głównego)
+#define POOL_EXTERNAL ((size_t) -1)
+
+// Typ funkcji wykonującej zadanie - worker to numer wątku puli
+typedef void (*taskFunction)(void *arg, size_t worker);
+
+/**
+ * Zadanie do wykonania przez pulę wątków.
+ * run - funkcja wykonująca zadanie
+ * arg - argument funkcji
+ */
+struct task {
+    taskFunction run;
+    void *arg;
+};
+typedef struct task task;
+
+/**
+ * Dwustronna kolejka zadań jednego wątku. Właściciel dokłada i zdejmuje
+ * zadania z końca (tail), a inne wątki kradną je z początku (head).
+ * lock - blokada kolejki
+ * items - bufor cykliczny zadań
+ * head, tail - liczniki zadań zdjętych z początku i dołożonych na koniec
+ * capacity - rozmiar bufora (potęga dwójki)
+ */
+struct taskDeque {
+    pthread_mutex_t lock;
+    task *items;
+    size_t head, tail;
+    size_t capacity;
+};
+typedef struct taskDeque taskDeque;
+
+struct workerPool;
+
+/**
+ * Dane jednego wątku puli.
+ * pool - pula
+ * index - numer wątku
+ * thread - wątek
+ */
+struct poolWorker {
+    struct workerPool *pool;
+    size_t index;
+    pthread_t thread;
+};
+typedef struct poolWorker poolWorker;
+
+/**
+ * Pula wątków z podkradaniem zadań (work stealing). Każdy wątek ma własną
+ * kolejkę, a gdy jest ona pusta, kradnie zadania z kolejek losowo wybranych
+ * wątków. Zadania mogą zlecać kolejne zadania.
+ * size - liczba wątków
+ * workers - wątki puli
+ * deques - kolejki zadań wątków
+ * pending - liczba zleconych, jeszcze niezakończonych zadań
+ * next - licznik rozdzielający zadania spoza puli między kolejki
+ * stop - prośba o zakończenie pracy wątków
+ */
+struct workerPool {
+    size_t size;
+    poolWorker *workers;
+    taskDeque *deques;
+    atomic_size_t pending;
+    atomic_size_t next;
+    atomic_bool stop;
+};
+typedef struct workerPool workerPool;
+
+// Funkcja tworząca pulę size wątków
+extern workerPool *poolCreate(size_t size);
+
+// Funkcja zlecająca zadanie - worker to numer zlecającego wątku puli
+// albo POOL_EXTERNAL
+extern void poolSubmit(workerPool *pool, size_t worker, taskFunction run,
+                       void *arg);
+
+// Funkcja czekająca na zakończenie wszystkich zleconych zadań
+extern void poolWait(workerPool *pool);
+
+// Funkcja kończąca pracę wątków i zwalniająca pamięć puli
+extern void poolDestroy(workerPool *pool);
+
+#endif //POOL_H
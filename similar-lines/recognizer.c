@@ -1,15 +1,39 @@
 #include "recognizer.h"
 #include "multiset.h"
+#include "arena.h"
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
+#include <ctype.h>
 #include <math.h>
+#include <stdint.h>
+#include <stdatomic.h>
 
 // Podstawy poszczególnych systemów liczbowych
 #define BASE_OCTAL 8
 #define BASE_DECIMAL 10
 #define BASE_HEXADECIMAL 16
 
+/**
+ * Pamięć podręczna rozpoznanych słów jednego wątku.
+ * entries - miejsca pamięci, wybierane skrótem słowa
+ * hits - liczba słów znalezionych w pamięci
+ * misses - liczba słów rozpoznanych od początku
+ */
+struct tokenCache {
+    _Alignas(64) tokenCacheEntry entries[TOKEN_CACHE_SLOTS];
+    size_t hits;
+    size_t misses;
+};
+typedef struct tokenCache tokenCache;
+
+// Pamięć podręczna wątku - wątki parsują wiersze niezależnie, bez blokad
+static _Thread_local tokenCache cache;
+
+// Liczniki pamięci podręcznej zebrane ze wszystkich wątków
+static atomic_size_t totalHits, totalMisses;
+
 /**
  * Uniwersalna funkcja realokująca pamięć dla elementów dowolnego typu.
  * Sprawdza, czy potrzeba realokować pamięć i robi to, gdy jest konieczne.
@@ -33,6 +57,93 @@ void *expand(void *x, size_t typeSize, size_t current, size_t *reserved) {
         return x;
 }
 
+/**
+ * Funkcja zwracająca miejsce na kolejne słowo danego typu w multizbiorze.
+ * Dopóki słowa mieszczą się w tablicy local, nie przydziela pamięci. Przy jej
+ * przepełnieniu przenosi słowa do areny, a dalej podwaja tablicę za każdym
+ * razem, gdy liczba słów osiąga potęgę dwójki. Pojemność musi być potęgą
+ * dwójki. Gdy słów jest już MAX_WORDS, zaznacza przepełnienie i zwraca NULL
+ * - licznik nie może się przekręcić, bo tablica local nadpisałaby wtedy
+ * wskaźnik heap.
+ * storage - unia z tablicą local i wskaźnikiem heap danego typu
+ * typeSize - rozmiar typu przechowywanych słów
+ * capacity - pojemność tablicy local
+ * size - liczba słów danego typu, zwiększana o jeden
+ * overflow - miejsce na informację o przepełnieniu
+ * memory - arena, w której przydzielane są tablice
+ */
+static void *appendSlot(void *storage, size_t typeSize, size_t capacity,
+                        uint32_t *size, bool *overflow, arena *memory) {
+    size_t current;
+    void *x;
+
+    if (*size == MAX_WORDS) {
+        *overflow = true;
+        return NULL;
+    }
+
+    current = (*size)++;
+
+    if (current < capacity)
+        return (char *) storage + current * typeSize;
+
+    // Wskaźnik heap jest odczytywany i zapisywany przez memcpy, bo w unii
+    // ma typ zależny od przechowywanych słów
+    if (current == capacity) {
+        x = arenaAlloc(memory, 2 * capacity * typeSize, typeSize);
+        memcpy(x, storage, capacity * typeSize);
+    }
+    else {
+        memcpy(&x, storage, sizeof(void *));
+
+        if ((current & (current - 1)) == 0)
+            x = arenaGrow(memory, x, current * typeSize,
+                          2 * current * typeSize, typeSize);
+    }
+
+    memcpy(storage, &x, sizeof(void *));
+    return (char *) x + current * typeSize;
+}
+
+/**
+ * Funkcje dopisujące słowo danego typu do multizbioru.
+ * set - multizbiór, do którego dopisywane jest słowo
+ * x - słowo
+ * memory - arena, w której przydzielane są tablice
+ */
+static void addUnsigInt(multiset *set, unsigned long long x, arena *memory) {
+    unsigned long long *slot = appendSlot(&set->unsigInts,
+                                          sizeof(unsigned long long),
+                                          INLINE_INTS, &set->sizeUnsigInts,
+                                          &set->overflow, memory);
+    if (slot != NULL)
+        *slot = x;
+}
+
+static void addSigInt(multiset *set, long long x, arena *memory) {
+    long long *slot = appendSlot(&set->sigInts, sizeof(long long),
+                                 INLINE_INTS, &set->sizeSigInts,
+                                 &set->overflow, memory);
+    if (slot != NULL)
+        *slot = x;
+}
+
+static void addAnyFloat(multiset *set, long double x, arena *memory) {
+    long double *slot = appendSlot(&set->anyFloats, sizeof(long double),
+                                   INLINE_FLOATS, &set->sizeAnyFloats,
+                                   &set->overflow, memory);
+    if (slot != NULL)
+        *slot = x;
+}
+
+static void addNotNumber(multiset *set, char *x, arena *memory) {
+    char **slot = appendSlot(&set->notNumbers, sizeof(char *),
+                             INLINE_WORDS, &set->sizeNotNumbers,
+                             &set->overflow, memory);
+    if (slot != NULL)
+        *slot = x;
+}
+
 /**
  * Funkcja, która rozpoznaje czy dany ciąg znaków jest nieskończonością.
  * Sprawdza, czy dany ciąg nie reprezentuje inf, +inf lub -inf. Wówczas
@@ -215,19 +326,45 @@ static bool recognizeOctal(char *word, size_t size) {
     return true;
 }
 
+/**
+ * Funckja, która zmienia wszystkie duże litery w tablicy na małe.
+ * word - tablica znaków, której duże litery zostaną zmniejszone
+ * size - rozmiar dostarczonej tablicy znaków
+ */
+static char *convertBigLetters(char *word, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (word[i] >= 'A' && word[i] <= 'Z')
+            word[i] = (char) tolower(word[i]);
+    }
+
+    return word;
+}
+
+/**
+ * Funkcja sprawdzająca, czy w tablicy znaków jest duża litera.
+ * word - tablica znaków
+ * size - rozmiar dostarczonej tablicy znaków
+ */
+static bool hasBigLetters(const char *word, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (word[i] >= 'A' && word[i] <= 'Z')
+            return true;
+    }
+
+    return false;
+}
+
 /**
  * Funkcja, która dostając nieliczbę, zwraca multizbiór z nią w środku.
  * set - multizbiór, w którym chcę umieścić słowo
  * word - ciąg znaków składający się w słowo
  * size - ilość znaków w ciągu word
+ * memory - arena, w której przydzielana jest pamięć na słowo
+ * foldCase - czy zmieniać w kopii duże litery na małe
  */
-static multiset processNotNumber(multiset set, char *word, size_t size) {
-    char *x = malloc((size + 1) * sizeof(char));
-
-    // Awaryjne wyjście z programu w przypadku braku pamięci
-    if (x == NULL)
-        exit(1);
-
+static void processNotNumber(multiset *set, const char *word, size_t size,
+                             arena *memory, bool foldCase) {
+    char *x = arenaAlloc(memory, (size + 1) * sizeof(char), sizeof(char));
     size_t i;
 
     // Kopiuję słowo ze względu na charakter funkcji strtok
@@ -236,22 +373,20 @@ static multiset processNotNumber(multiset set, char *word, size_t size) {
 
     x[i] = '\0';
 
-    set.notNumbers = expand(set.notNumbers, sizeof(set.notNumbers),
-                            set.sizeNotNumbers, &set.maxSizeNotNumbers);
+    if (foldCase)
+        convertBigLetters(x, size);
 
-    set.notNumbers[set.sizeNotNumbers] = x;
-    ++set.sizeNotNumbers;
-
-    return set;
+    addNotNumber(set, x, memory);
 }
 
 /**
- * Funkcja, która dostając liczbę przecinkową zwraca multizbiór z nią w środku.
- * set - multizbiór, w którym chcę umieścić słowo
+ * Funkcja, która zamienia liczbę przecinkową na wartość słowa. Liczba
+ * całkowita zapisana zmiennoprzecinkowo staje się liczbą całkowitą.
  * word - ciąg znaków składający się w słowo
  * size - ilość znaków w ciągu word
+ * result - miejsce na typ i wartość słowa
  */
-static multiset processAnyFloat(multiset set, char *word, size_t size) {
+static void processAnyFloat(char *word, size_t size, classifiedWord *result) {
     char *ptr;
     long double x = 0;
 
@@ -270,111 +405,265 @@ static multiset processAnyFloat(multiset set, char *word, size_t size) {
     if (x >= 0) {
         // Jeśli liczba zapisana zmiennoprzecinkowo jest całkowita nieujemna
         if (x - (unsigned long long) x == 0) {
-            set.unsigInts = expand(set.unsigInts, sizeof(unsigned long long),
-                                   set.sizeUnsigInts, &set.maxSizeUnsigInts);
-
-            set.unsigInts[set.sizeUnsigInts] = (unsigned long long) x;
-            ++set.sizeUnsigInts;
-
-            return set;
+            result->type = WORD_UNSIG_INT;
+            result->value.unsigInt = (unsigned long long) x;
+            return;
         }
     }
     else {
         // Jeśli liczba zapisana zmiennoprzecinkowo jest całkowita ujemna
         if (x - (long long) x == 0) {
-            set.sigInts = expand(set.sigInts, sizeof(long long),
-                                 set.sizeSigInts, &set.maxSizeSigInts);
-
-            set.sigInts[set.sizeSigInts] = (long long) x;
-            ++set.sizeSigInts;
-
-            return set;
+            result->type = WORD_SIG_INT;
+            result->value.sigInt = (long long) x;
+            return;
         }
     }
 
-    set.anyFloats = expand(set.anyFloats, sizeof(long double),
-                           set.sizeAnyFloats, &set.maxSizeAnyFloats);
-
-    set.anyFloats[set.sizeAnyFloats] = x;
-    ++set.sizeAnyFloats;
-
-    return set;
+    result->type = WORD_ANY_FLOAT;
+    result->value.anyFloat = x;
 }
 
 /**
- * Funkcja, która dostając liczbę całkowitą dodatnią, zwraca multizbiór z nią.
- * set - multizbiór, w którym chcę umieścić słowo
+ * Funkcja, która zamienia liczbę całkowitą dodatnią na wartość słowa.
  * word - ciąg znaków składający się w słowo
- * size - ilość znaków w ciągu word
+ * base - podstawa systemu liczbowego
+ * result - miejsce na typ i wartość słowa
  */
-static multiset processUnsigInt(multiset set, char *word, int base) {
+static void processUnsigInt(char *word, int base, classifiedWord *result) {
     char *ptr;
-    // Konwertuję słowo na unsigned long long
-    unsigned long long x = strtoull(word, &ptr, base);
-
-    set.unsigInts = expand(set.unsigInts, sizeof(unsigned long long),
-                           set.sizeUnsigInts, &set.maxSizeUnsigInts);
-
-    set.unsigInts[set.sizeUnsigInts] = x;
-    ++set.sizeUnsigInts;
 
-    return set;
+    // Konwertuję słowo na unsigned long long
+    result->type = WORD_UNSIG_INT;
+    result->value.unsigInt = strtoull(word, &ptr, base);
 }
 
 /**
- * Liczba, która dostając liczbę całkowitą ujemną, zwraca multizbiór z nią.
- * set - multizbiór, w którym chcę umieścić słowo
+ * Funkcja, która zamienia liczbę całkowitą ujemną na wartość słowa.
  * word - ciąg znaków składający się w słowo
- * size - ilość znaków w ciągu word
+ * result - miejsce na typ i wartość słowa
  */
-static multiset processSigInt(multiset set, char *word) {
+static void processSigInt(char *word, classifiedWord *result) {
     char *ptr;
     // Konwertuję słowo na long long
     long long x = strtoll(word, &ptr, 10);
 
+    // Jeśli słowo jest zerem, traktuję jako nieujemną
     if (x == 0) {
-        // Jeśli słowo jest zerem, traktuję jako nieujemną
-        set.unsigInts = expand(set.unsigInts, sizeof(unsigned long long),
-                               set.sizeUnsigInts, &set.maxSizeUnsigInts);
-
-        set.unsigInts[set.sizeUnsigInts] = (unsigned long long) x;
-        ++set.sizeUnsigInts;
+        result->type = WORD_UNSIG_INT;
+        result->value.unsigInt = 0;
     }
     else {
-        set.sigInts = expand(set.sigInts, sizeof(long long),
-                             set.sizeSigInts, &set.maxSizeSigInts);
+        result->type = WORD_SIG_INT;
+        result->value.sigInt = x;
+    }
+}
 
-        set.sigInts[set.sizeSigInts] = x;
-        ++set.sizeSigInts;
+/**
+ * Funkcja umieszczająca rozpoznane słowo w multizbiorze.
+ * set - multizbiór, w którym chcę umieścić słowo
+ * result - typ i wartość słowa
+ * word - "nieliczba", używana tylko dla słów typu WORD_NOT_NUMBER
+ * size - ilość znaków w ciągu word
+ * memory - arena, w której przydzielana jest pamięć na słowo
+ * foldCase - czy zmieniać w kopii "nieliczby" duże litery na małe
+ */
+static void addClassified(multiset *set, const classifiedWord *result,
+                          const char *word, size_t size, arena *memory,
+                          bool foldCase) {
+    switch (result->type) {
+        case WORD_UNSIG_INT:
+            addUnsigInt(set, result->value.unsigInt, memory);
+            break;
+        case WORD_SIG_INT:
+            addSigInt(set, result->value.sigInt, memory);
+            break;
+        case WORD_ANY_FLOAT:
+            addAnyFloat(set, result->value.anyFloat, memory);
+            break;
+        default:
+            processNotNumber(set, word, size, memory, foldCase);
     }
+}
 
-    return set;
+/**
+ * Funkcja obliczająca skrót krótkiego surowego słowa, wybierający miejsce
+ * w pamięci podręcznej. Zamiast przeglądać słowo znak po znaku, miesza
+ * jego pierwsze i ostatnie 8 bajtów oraz długość - kilka mnożeń niezależnie
+ * od długości słowa.
+ * word - ciąg znaków, nie dłuższy niż TOKEN_CACHE_WORD
+ * size - ilość znaków w ciągu word
+ */
+static size_t hashWord(const char *word, size_t size) {
+    uint64_t head = 0, tail = 0, h;
+
+    if (size >= sizeof(uint64_t)) {
+        memcpy(&head, word, sizeof(uint64_t));
+        memcpy(&tail, word + size - sizeof(uint64_t), sizeof(uint64_t));
+    }
+    else {
+        memcpy(&head, word, size);
+    }
+
+    h = (head * 0x9e3779b97f4a7c15ULL) ^ (tail + size) * 0xbf58476d1ce4e5b9ULL;
+    return (size_t) (h ^ h >> 29);
 }
 
 /**
- * Funkcja, która dany ciąg znaków przetwarza w słowo, zamieszcza w odpowiednie
- * miejsce w multizbiorze i zwraca multizbiór z nią.
+ * Wzorzec funkcji, która dany ciąg znaków przetwarza w słowo i zamieszcza
+ * w odpowiednie miejsce w multizbiorze. Parametry reguł są w każdym
+ * wariancie stałymi, więc po wstawieniu wzorca kompilator usuwa nieużywane
+ * kroki i sprawdzenia - w wariancie nie zostają rozgałęzienia na regułach.
+ * Krótkie słowa są najpierw szukane w pamięci podręcznej wątku - powtórzone
+ * słowo nie przechodzi ponownie przez rozpoznawanie i konwersję, a nowe
+ * słowo zastępuje słowo zajmujące jego miejsce. Pamięć trzyma surowe słowo,
+ * więc "nieliczba" z pamięci jest przy kopiowaniu zmieniana na małe litery.
+ * Liczby są zawsze rozpoznawane bez względu na wielkość liter - bez składania
+ * wielkości liter rozpoznawana jest kopia słowa z małymi literami (tymczasowo
+ * w arenie), a oryginalna wielkość liter zostaje tylko "nieliczbom".
  * set - multizbiór, w którym chcę umieścić słowo
  * word - ciąg znaków składający się w słowo
  * size - ilość znaków w ciągu word
+ * memory - arena, w której przydzielana jest pamięć na słowo
+ * rules - numer zestawu reguł zwiększony o 1
+ * foldCase - czy zmieniać duże litery na małe
+ * octal - czy rozpoznawać liczby ósemkowe
+ * hex - czy rozpoznawać liczby szesnastkowe
  */
-multiset processWord(multiset set, char *word, size_t wordSize) {
-    if (recognizeOctal(word, wordSize)) {
-        return processUnsigInt(set, word, BASE_OCTAL);
+static inline __attribute__((always_inline))
+void classifyWord(multiset *set, char *word, size_t wordSize, arena *memory,
+                  uint8_t rules, bool foldCase, bool octal, bool hex) {
+    tokenCacheEntry *entry = NULL;
+    classifiedWord result;
+    char *original = word;
+    arenaMark mark;
+    bool copied = false;
+
+    ++cache.misses;
+
+    if (wordSize <= TOKEN_CACHE_WORD) {
+        entry = &cache.entries[hashWord(word, wordSize)
+                               & (TOKEN_CACHE_SLOTS - 1)];
+
+        if (entry->rules == rules && entry->size == wordSize
+            && memcmp(entry->word, word, wordSize) == 0) {
+            --cache.misses;
+            ++cache.hits;
+            addClassified(set, &entry->result, entry->word, wordSize,
+                          memory, foldCase);
+            return;
+        }
+
+        // Surowe słowo jest kluczem, więc trzeba je zapamiętać przed
+        // zmianą wielkości liter
+        entry->rules = rules;
+        entry->size = (uint8_t) wordSize;
+        memcpy(entry->word, word, wordSize);
+    }
+
+    if (foldCase) {
+        word = convertBigLetters(word, wordSize);
+    }
+    else if (hasBigLetters(word, wordSize)) {
+        mark = arenaGetMark(memory);
+        word = arenaAlloc(memory, wordSize + 1, sizeof(char));
+        memcpy(word, original, wordSize);
+        word[wordSize] = '\0';
+        convertBigLetters(word, wordSize);
+        copied = true;
+    }
+
+    if (octal && recognizeOctal(word, wordSize)) {
+        processUnsigInt(word, BASE_OCTAL, &result);
     }
     else if (recognizeUnsigInt(word, wordSize)) {
-        return processUnsigInt(set, word, BASE_DECIMAL);
+        processUnsigInt(word, BASE_DECIMAL, &result);
     }
     else if (recognizeSigInt(word, wordSize)) {
-        return processSigInt(set, word);
+        processSigInt(word, &result);
     }
-    else if (recognizeHex(word, wordSize)) {
-        return processUnsigInt(set, word, BASE_HEXADECIMAL);
+    else if (hex && recognizeHex(word, wordSize)) {
+        processUnsigInt(word, BASE_HEXADECIMAL, &result);
     }
     else if (recognizeAnyFloat(word, wordSize)) {
-        return processAnyFloat(set, word, wordSize);
+        processAnyFloat(word, wordSize, &result);
     }
     else {
-        return processNotNumber(set, word, wordSize);
+        result.type = WORD_NOT_NUMBER;
     }
+
+    if (entry != NULL)
+        entry->result = result;
+
+    // Kopia z małymi literami nie jest już potrzebna
+    if (copied) {
+        arenaRelease(memory, mark);
+        word = original;
+    }
+
+    addClassified(set, &result, word, wordSize, memory, false);
+}
+
+/**
+ * Zestawy reguł rozpoznawania słów, w kolejności indeksów tablicy
+ * processors: X(nazwa funkcji, numer zestawu zwiększony o 1, składanie
+ * wielkości liter, liczby ósemkowe, liczby szesnastkowe). Indeks wariantu to
+ * 4 * caseSensitive + 2 * noOctal + hexAsWord.
+ */
+#define RULE_SETS(X) \
+    X(processWord, 1, true, true, true) \
+    X(processWordHexAsWord, 2, true, true, false) \
+    X(processWordNoOctal, 3, true, false, true) \
+    X(processWordNoOctalHexAsWord, 4, true, false, false) \
+    X(processWordCaseSensitive, 5, false, true, true) \
+    X(processWordCaseSensitiveHexAsWord, 6, false, true, false) \
+    X(processWordCaseSensitiveNoOctal, 7, false, false, true) \
+    X(processWordCaseSensitiveNoOctalHexAsWord, 8, false, false, false)
+
+// Wariant domyślny jest dostępny poza modułem, pozostałe przez wskaźnik
+#define DEFINE_VARIANT(name, rules, foldCase, octal, hex) \
+    void name(multiset *set, char *word, size_t wordSize, arena *memory) { \
+        classifyWord(set, word, wordSize, memory, rules, foldCase, octal, \
+                     hex); \
+    }
+
+#define VARIANT_ENTRY(name, rules, foldCase, octal, hex) name,
+
+RULE_SETS(DEFINE_VARIANT)
+
+// Tablica wariantów, z której wariant jest wybierany raz, przy starcie
+static const wordProcessor processors[] = {RULE_SETS(VARIANT_ENTRY)};
+
+/**
+ * Funkcja wybierająca wariant przetwarzania słów dla zadanych reguł.
+ * caseSensitive - czy rozróżniać wielkość liter
+ * noOctal - czy traktować liczby z wiodącym zerem jako dziesiętne
+ * hexAsWord - czy traktować liczby szesnastkowe jako "nieliczby"
+ */
+wordProcessor selectWordProcessor(bool caseSensitive, bool noOctal,
+                                  bool hexAsWord) {
+    return processors[4 * caseSensitive + 2 * noOctal + hexAsWord];
+}
+
+/**
+ * Funkcja dodająca liczniki pamięci podręcznej bieżącego wątku do liczników
+ * wspólnych dla wszystkich wątków i zerująca je. Wątek parsujący wywołuje ją
+ * po skończeniu pracy, więc w pętli parsowania nie ma operacji atomowych.
+ */
+void tokenCacheFlush(void) {
+    atomic_fetch_add_explicit(&totalHits, cache.hits, memory_order_relaxed);
+    atomic_fetch_add_explicit(&totalMisses, cache.misses,
+                              memory_order_relaxed);
+    cache.hits = 0;
+    cache.misses = 0;
+}
+
+/**
+ * Funkcja zwracająca liczniki pamięci podręcznej ze wszystkich wątków,
+ * które wywołały tokenCacheFlush.
+ */
+tokenCacheStats tokenCacheGetStats(void) {
+    tokenCacheStats stats;
+    stats.hits = atomic_load_explicit(&totalHits, memory_order_relaxed);
+    stats.misses = atomic_load_explicit(&totalMisses, memory_order_relaxed);
+    return stats;
 }
@@ -1,12 +1,91 @@
 #include "multiset.h"
+#include "arena.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #ifndef PARSING_H
 #define PARSING_H
 
+// Liczba miejsc pamięci podręcznej rozpoznanych słów (potęga dwójki)
+#define TOKEN_CACHE_SLOTS 1024
+
+// Najdłuższe słowo przechowywane w pamięci podręcznej
+#define TOKEN_CACHE_WORD 24
+
+/**
+ * Typ rozpoznanego słowa.
+ */
+enum wordType {
+    WORD_UNSIG_INT,
+    WORD_SIG_INT,
+    WORD_ANY_FLOAT,
+    WORD_NOT_NUMBER
+};
+typedef enum wordType wordType;
+
+/**
+ * Rozpoznane słowo: typ i wartość po konwersji.
+ * type - typ słowa
+ * value - wartość liczby (nieużywana dla "nieliczb")
+ */
+struct classifiedWord {
+    wordType type;
+    union {
+        unsigned long long unsigInt;
+        long long sigInt;
+        long double anyFloat;
+    } value;
+};
+typedef struct classifiedWord classifiedWord;
+
+/**
+ * Miejsce pamięci podręcznej: surowe słowo i wynik jego rozpoznania.
+ * Zajmuje 64 bajty, czyli jedną linię pamięci podręcznej procesora.
+ * result - typ i wartość słowa
+ * word - surowe słowo, przed zmianą wielkości liter (bez znaku '\0')
+ * size - długość słowa
+ * rules - numer zestawu reguł zwiększony o 1 (0 - wolne miejsce)
+ */
+struct tokenCacheEntry {
+    classifiedWord result;
+    char word[TOKEN_CACHE_WORD];
+    uint8_t size;
+    uint8_t rules;
+};
+typedef struct tokenCacheEntry tokenCacheEntry;
+
+/**
+ * Liczniki pamięci podręcznej rozpoznanych słów.
+ * hits - słowa znalezione w pamięci podręcznej
+ * misses - słowa rozpoznane od początku
+ */
+struct tokenCacheStats {
+    size_t hits;
+    size_t misses;
+};
+typedef struct tokenCacheStats tokenCacheStats;
+
 // Uniwersalna funkcja realokująca pamięć dla elementów dowolnego typu
 extern void *expand(void *x, size_t typeSize, size_t current, size_t *reserved);
 
-// Funkcja przetwarzająca dane słowo i przekazująca multizbiór z nim w środku
-extern multiset processWord(multiset set, char *word, size_t wordSize);
+// Typ funkcji przetwarzającej słowo według jednego z zestawów reguł
+typedef void (*wordProcessor)(multiset *set, char *word, size_t wordSize,
+                              arena *memory);
+
+// Funkcja przetwarzająca dane słowo według domyślnych reguł i umieszczająca
+// je w multizbiorze
+extern void processWord(multiset *set, char *word, size_t wordSize,
+                        arena *memory);
+
+// Funkcja wybierająca wariant przetwarzania słów dla zadanych reguł
+extern wordProcessor selectWordProcessor(bool caseSensitive, bool noOctal,
+                                         bool hexAsWord);
+
+// Funkcja dodająca liczniki pamięci podręcznej wątku do liczników wspólnych
+extern void tokenCacheFlush(void);
+
+// Funkcja zwracająca liczniki pamięci podręcznej ze wszystkich wątków
+extern tokenCacheStats tokenCacheGetStats(void);
 
 #endif //PARSING_H
\ No newline at end of file
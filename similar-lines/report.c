@@ -0,0 +1,200 @@
+#include "report.h"
+#include "encoder.h"
+#include "digest.h"
+#include "recognizer.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * Funkcja sprawdzająca, czy grupa x jest mniej istotna niż grupa y.
+ * Mniej istotna jest grupa mniejsza, a przy równych rozmiarach ta,
+ * która zaczyna się później.
+ * x - pierwsza grupa
+ * y - druga grupa
+ */
+static bool lessImportant(const group *x, const group *y) {
+    if (x->size != y->size)
+        return x->size < y->size;
+    else
+        return x->lines[0] > y->lines[0];
+}
+
+/**
+ * Funkcja przywracająca własność kopca od zadanego węzła w dół.
+ * r - moduł wypisujący
+ * i - indeks węzła
+ */
+static void siftDown(reporter *r, size_t i) {
+    size_t smallest, left, right;
+    group tmp;
+
+    while (true) {
+        smallest = i;
+        left = 2 * i + 1;
+        right = 2 * i + 2;
+
+        if (left < r->heapSize && lessImportant(&r->heap[left],
+                                                &r->heap[smallest]))
+            smallest = left;
+        if (right < r->heapSize && lessImportant(&r->heap[right],
+                                                 &r->heap[smallest]))
+            smallest = right;
+
+        if (smallest == i)
+            return;
+
+        tmp = r->heap[i];
+        r->heap[i] = r->heap[smallest];
+        r->heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+/**
+ * Funkcja przywracająca własność kopca od zadanego węzła w górę.
+ * r - moduł wypisujący
+ * i - indeks węzła
+ */
+static void siftUp(reporter *r, size_t i) {
+    group tmp;
+
+    while (i > 0 && lessImportant(&r->heap[i], &r->heap[(i - 1) / 2])) {
+        tmp = r->heap[i];
+        r->heap[i] = r->heap[(i - 1) / 2];
+        r->heap[(i - 1) / 2] = tmp;
+        i = (i - 1) / 2;
+    }
+}
+
+/**
+ * Funkcja kopiująca numery wierszy grupy do zapamiętania.
+ * lines - numery wierszy
+ * size - liczba wierszy
+ * digest - skrót grupy
+ */
+static group copyGroup(const size_t *lines, size_t size, uint64_t digest) {
+    group g;
+    g.lines = malloc(size * sizeof(size_t));
+    g.size = size;
+    g.digest = digest;
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (g.lines == NULL)
+        exit(1);
+
+    memcpy(g.lines, lines, size * sizeof(size_t));
+    return g;
+}
+
+/**
+ * Funkcja przygotowująca moduł wypisujący.
+ * r - moduł wypisujący
+ * opts - opcje programu
+ * fd - deskryptor, do którego wypisywane są grupy
+ */
+void reporterInit(reporter *r, const options *opts, int fd) {
+    r->minGroup = opts->minGroup;
+    r->top = opts->top;
+    r->heapSize = 0;
+    r->heapReserved = 0;
+    r->heap = NULL;
+    encoderInit(&r->out, fd, opts->form, opts->digest);
+}
+
+/**
+ * Funkcja sprawdzająca, czy grupa o danym rozmiarze zostanie wypisana lub
+ * zapamiętana. Przy równym rozmiarze nowa grupa zaczyna się później niż
+ * zapamiętane, więc wystarczy porównać rozmiary.
+ * r - moduł wypisujący
+ * size - liczba wierszy grupy
+ */
+static bool wanted(reporter *r, size_t size) {
+    if (size < r->minGroup)
+        return false;
+
+    return r->top == 0 || r->heapSize < r->top || size > r->heap[0].size;
+}
+
+/**
+ * Funkcja przyjmująca kolejną grupę podobnych wierszy o znanym skrócie.
+ * Grupy muszą przychodzić w kolejności rosnących pierwszych wierszy.
+ * Bez ograniczenia liczby grup od razu wypisuje grupę, a w przeciwnym
+ * wypadku zapamiętuje ją, jeśli jest istotniejsza od najmniej istotnej
+ * z zapamiętanych grup.
+ * r - moduł wypisujący
+ * lines - numery wierszy grupy w kolejności rosnącej
+ * size - liczba wierszy grupy
+ * digest - skrót multizbioru grupy
+ */
+void reportGroupDigest(reporter *r, const size_t *lines, size_t size,
+                       uint64_t digest) {
+    if (!wanted(r, size))
+        return;
+
+    if (r->top == 0) {
+        encodeGroup(&r->out, lines, size, digest);
+    }
+    else if (r->heapSize < r->top) {
+        // Kopiec nie jest większy niż liczba dotąd zapamiętanych grup
+        r->heap = expand(r->heap, sizeof(group), r->heapSize,
+                         &r->heapReserved);
+        r->heap[r->heapSize] = copyGroup(lines, size, digest);
+        siftUp(r, r->heapSize++);
+    }
+    else {
+        free(r->heap[0].lines);
+        r->heap[0] = copyGroup(lines, size, digest);
+        siftDown(r, 0);
+    }
+}
+
+/**
+ * Funkcja przyjmująca kolejną grupę podobnych wierszy.
+ * Skrót grupy jest obliczany tylko wtedy, gdy jest wypisywany.
+ * r - moduł wypisujący
+ * lines - numery wierszy grupy w kolejności rosnącej
+ * size - liczba wierszy grupy
+ * set - posortowany multizbiór reprezentujący grupę
+ */
+void reportGroup(reporter *r, const size_t *lines, size_t size,
+                 multiset *set) {
+    if (wanted(r, size))
+        reportGroupDigest(r, lines, size,
+                          r->out.digest ? multisetDigest(set) : 0);
+}
+
+/**
+ * Funkcja porównująca dwie grupy po pierwszych wierszach do qsort.
+ * a - pierwsza grupa
+ * b - druga grupa
+ */
+static int compareFirstLines(const void *a, const void *b) {
+    const group *x = a;
+    const group *y = b;
+
+    if (x->lines[0] < y->lines[0])
+        return -1;
+    else if (x->lines[0] > y->lines[0])
+        return 1;
+    return 0;
+}
+
+/**
+ * Funkcja wypisująca zapamiętane grupy w kolejności pierwszych wierszy
+ * i zwalniająca pamięć modułu.
+ * r - moduł wypisujący
+ */
+void reportFinish(reporter *r) {
+    if (r->heapSize > 0)
+        qsort(r->heap, r->heapSize, sizeof(group), compareFirstLines);
+
+    for (size_t i = 0; i < r->heapSize; i++) {
+        encodeGroup(&r->out, r->heap[i].lines, r->heap[i].size,
+                    r->heap[i].digest);
+        free(r->heap[i].lines);
+    }
+
+    free(r->heap);
+    encoderFinish(&r->out);
+}
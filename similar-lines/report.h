@@ -0,0 +1,60 @@
+#include "options.h"
+#include "encoder.h"
+#include "multiset.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef REPORT_H
+#define REPORT_H
+
+/**
+ * Grupa podobnych wierszy zapamiętana do wypisania na końcu.
+ * lines - numery wierszy w kolejności rosnącej
+ * size - liczba wierszy grupy
+ * digest - skrót multizbioru grupy
+ */
+struct group {
+    size_t *lines;
+    size_t size;
+    uint64_t digest;
+};
+typedef struct group group;
+
+/**
+ * Moduł wypisujący znalezione grupy podobnych wierszy.
+ * Grupy mniejsze niż minGroup są pomijane bez formatowania. Gdy top > 0,
+ * zamiast wypisywać grupy od razu, trzyma top największych w kopcu, którego
+ * korzeniem jest najmniej istotna z zapamiętanych grup. Kopiec rośnie wraz
+ * z liczbą zapamiętanych grup, a nie od razu do rozmiaru top.
+ * minGroup - minimalna liczba wierszy wypisywanej grupy
+ * top - liczba największych grup do wypisania (0 oznacza wszystkie)
+ * heap - kopiec zapamiętanych grup
+ * heapSize - liczba grup w kopcu
+ * heapReserved - liczba grup, na które jest miejsce w kopcu
+ * out - koder zapisujący grupy na standardowe wyjście
+ */
+struct reporter {
+    size_t minGroup;
+    size_t top;
+    group *heap;
+    size_t heapSize;
+    size_t heapReserved;
+    encoder out;
+};
+typedef struct reporter reporter;
+
+// Funkcja przygotowująca moduł wypisujący do fd według opcji programu
+extern void reporterInit(reporter *r, const options *opts, int fd);
+
+// Funkcja przyjmująca kolejną grupę, w kolejności pierwszych wierszy
+extern void reportGroup(reporter *r, const size_t *lines, size_t size,
+                        multiset *set);
+
+// Funkcja przyjmująca kolejną grupę o znanym już skrócie
+extern void reportGroupDigest(reporter *r, const size_t *lines, size_t size,
+                              uint64_t digest);
+
+// Funkcja wypisująca zapamiętane grupy i zwalniająca pamięć modułu
+extern void reportFinish(reporter *r);
+
+#endif //REPORT_H
@@ -0,0 +1,231 @@
+// Flaga potrzebna do poprawnego działania funkcji fork, pipe i fdopen
+#define _GNU_SOURCE
+
+#include "shard.h"
+#include "multiset.h"
+#include "parser.h"
+#include "similar.h"
+#include "digest.h"
+#include "encoder.h"
+#include "arena.h"
+#include "reader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+// Rozmiar bufora przy kopiowaniu nieprzewijalnego wejścia do pliku
+#define SPOOL_BUFFER_SIZE (1 << 20)
+
+/**
+ * Funkcja zwracająca deskryptor pliku z danymi wejściowymi, który każdy
+ * proces potomny może czytać od zadanego miejsca funkcją pread.
+ * Zwykły plik podany na standardowe wejście jest czytany bezpośrednio,
+ * a dane z potoku są najpierw kopiowane do pliku tymczasowego.
+ * offset - miejsce na pozycję, od której należy czytać dane
+ */
+static int prepareInput(off_t *offset) {
+    struct stat info;
+    char *buffer;
+    ssize_t count;
+    FILE *spool;
+
+    if (fstat(STDIN_FILENO, &info) == 0 && S_ISREG(info.st_mode)
+        && (*offset = lseek(STDIN_FILENO, 0, SEEK_CUR)) >= 0)
+        return STDIN_FILENO;
+
+    spool = tmpfile();
+    buffer = malloc(SPOOL_BUFFER_SIZE);
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci lub miejsca
+    if (spool == NULL || buffer == NULL)
+        exit(1);
+
+    while ((count = read(STDIN_FILENO, buffer, SPOOL_BUFFER_SIZE)) != 0) {
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0 || write(fileno(spool), buffer, count) != count)
+            exit(1);
+    }
+
+    free(buffer);
+    *offset = 0;
+    return fileno(spool);
+}
+
+/**
+ * Funkcja wykonywana przez proces potomny obsługujący jedną część danych.
+ * Parsuje wszystkie wiersze, ale zatrzymuje tylko te, których skrót
+ * posortowanego multizbioru należy do jego części - pamięć pozostałych jest
+ * od razu zwalniana. Znalezione grupy zapisuje w formacie binarnym do
+ * potoku. Komunikaty o błędnych wierszach wypisuje tylko część 0.
+ * shard - numer części
+ * opts - opcje programu
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ * fd - deskryptor pliku z danymi
+ * offset - miejsce, od którego należy czytać dane
+ * out - deskryptor potoku do procesu nadrzędnego
+ */
+static void runWorker(size_t shard, const options *opts, wordProcessor process,
+                      int fd, off_t offset, int out) {
+    arena *memory = arenaCreate();
+    lineReader *reader = readerCreateAt(fd, offset);
+    multiset *text = malloc(DEFAULT_SIZE * sizeof(multiset));
+    size_t size = 0, reservedSize = DEFAULT_SIZE;
+    options workerOpts = *opts;
+    arenaMark mark;
+    reporter r;
+    parser p;
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (text == NULL)
+        exit(1);
+
+    parserInit(&p, reader, memory, process, shard == 0);
+
+    while (true) {
+        text = expand(text, sizeof(multiset), size, &reservedSize);
+        mark = arenaGetMark(memory);
+
+        if (!parseLine(&p, &text[size]))
+            break;
+
+        sortMultiset(&text[size]);
+
+        if (multisetDigest(&text[size]) % opts->shards == shard)
+            ++size;
+        else
+            arenaRelease(memory, mark);
+    }
+
+    readerDestroy(reader);
+
+    // Największe grupy wybiera proces nadrzędny, który widzi wszystkie
+    workerOpts.form = FORMAT_BINARY;
+    workerOpts.top = 0;
+    reporterInit(&r, &workerOpts, out);
+    findSimilar(text, size, &r);
+    reportFinish(&r);
+
+    arenaDestroy(memory);
+    free(text);
+}
+
+/**
+ * Funkcja scalająca grupy z potoków procesów potomnych w kolejności
+ * pierwszych wierszy. Każdy proces wypisuje swoje grupy w tej kolejności,
+ * więc wystarczy za każdym razem wybrać grupę o najmniejszym pierwszym
+ * wierszu spośród pierwszych nieprzetworzonych grup wszystkich procesów.
+ * pipes - strumienie potoków
+ * shards - liczba procesów potomnych
+ * r - moduł wypisujący grupy
+ */
+static void mergeGroups(FILE **pipes, size_t shards, reporter *r) {
+    decoder *in = malloc(shards * sizeof(decoder));
+    int *status = malloc(shards * sizeof(int));
+    size_t best;
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (in == NULL || status == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < shards; i++) {
+        if (!decoderInit(&in[i], pipes[i]))
+            exit(1);
+
+        status[i] = decodeGroup(&in[i]);
+    }
+
+    while (true) {
+        best = shards;
+
+        for (size_t i = 0; i < shards; i++) {
+            if (status[i] < 0)
+                exit(1);
+
+            if (status[i] == 1 && (best == shards
+                                   || in[i].lines[0] < in[best].lines[0]))
+                best = i;
+        }
+
+        if (best == shards)
+            break;
+
+        reportGroupDigest(r, in[best].lines, in[best].size,
+                          in[best].groupDigest);
+        status[best] = decodeGroup(&in[best]);
+    }
+
+    for (size_t i = 0; i < shards; i++)
+        decoderFinish(&in[i]);
+
+    free(in);
+    free(status);
+}
+
+/**
+ * Funkcja wyszukująca podobne wiersze w opts->shards procesach potomnych.
+ * Podobne wiersze mają równe skróty, więc trafiają do tej samej części,
+ * a scalone grupy są takie same jak w trybie jednoprocesowym.
+ * Błąd któregokolwiek procesu kończy program kodem 1.
+ * Liczniki wydajności obejmują też procesy potomne, ale ich praca przeplata
+ * się ze scalaniem, więc całość jest mierzona jako jedna faza.
+ * opts - opcje programu
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ * r - moduł wypisujący grupy
+ * c - liczniki wydajności faz
+ */
+void runShards(const options *opts, wordProcessor process, reporter *r,
+               counters *c) {
+    size_t shards = opts->shards;
+    FILE **pipes = malloc(shards * sizeof(FILE *));
+    pid_t *children = malloc(shards * sizeof(pid_t));
+    int fds[2], status, failed = 0;
+    off_t offset;
+    int fd = prepareInput(&offset);
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (pipes == NULL || children == NULL)
+        exit(1);
+
+    countersStart(c);
+    for (size_t i = 0; i < shards; i++) {
+        if (pipe(fds) != 0 || (children[i] = fork()) < 0)
+            exit(1);
+
+        if (children[i] == 0) {
+            close(fds[0]);
+
+            for (size_t j = 0; j < i; j++)
+                fclose(pipes[j]);
+
+            runWorker(i, opts, process, fd, offset, fds[1]);
+            _exit(0);
+        }
+
+        close(fds[1]);
+
+        if ((pipes[i] = fdopen(fds[0], "r")) == NULL)
+            exit(1);
+    }
+
+    mergeGroups(pipes, shards, r);
+
+    for (size_t i = 0; i < shards; i++) {
+        fclose(pipes[i]);
+
+        if (waitpid(children[i], &status, 0) < 0 || !WIFEXITED(status)
+            || WEXITSTATUS(status) != 0)
+            failed = 1;
+    }
+    countersStop(c, "shards+merge");
+
+    free(pipes);
+    free(children);
+
+    if (failed)
+        exit(1);
+}
@@ -0,0 +1,13 @@
+#include "options.h"
+#include "report.h"
+#include "recognizer.h"
+#include "counters.h"
+
+#ifndef SHARD_H
+#define SHARD_H
+
+// Funkcja wyszukująca podobne wiersze w opts->shards procesach potomnych
+extern void runShards(const options *opts, wordProcessor process, reporter *r,
+                      counters *c);
+
+#endif //SHARD_H
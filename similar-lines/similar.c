@@ -1,8 +1,75 @@
 #include "similar.h"
 #include "multiset.h"
+#include "report.h"
+#include "digest.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdatomic.h>
+
+// Minimalna liczba słów tablicy, którą opłaca się sortować równolegle
+#define PARALLEL_SORT_MIN (1 << 16)
+
+// Liczba słów we fragmencie tablicy sortowanym przez jedno zadanie
+#define PARALLEL_SORT_CHUNK (1 << 14)
+
+// Liczba słów, po której zebraniu wiersze trafiają do puli jako jedno zadanie
+#define SORT_STAGE_WORDS (1 << 14)
+
+// Największa liczba słów jednego typu zapisywana w skrócie wiersza
+#define HOT_SIZE_MAX 0xffffu
+
+// Typ funkcji porównującej dwa słowa, jak w qsort
+typedef int (*wordComparator)(const void *a, const void *b);
+
+/**
+ * Równoległe sortowanie jednej dużej tablicy słów. Fragmenty tablicy są
+ * sortowane przez osobne zadania puli, a ostatnie kończące się zadanie
+ * scala posortowane fragmenty.
+ * base - tablica słów
+ * count - liczba słów
+ * typeSize - rozmiar słowa
+ * compare - funkcja porównująca słowa
+ * chunks - liczba fragmentów
+ * remaining - liczba fragmentów, które nie zostały jeszcze posortowane
+ */
+struct sortJob {
+    char *base;
+    size_t count;
+    size_t typeSize;
+    wordComparator compare;
+    size_t chunks;
+    atomic_size_t remaining;
+};
+typedef struct sortJob sortJob;
+
+/**
+ * Skrót wiersza używany przy szukaniu grup ("gorąca" część danych).
+ * Pętla porównująca wiersze czyta tylko tablicę skrótów, po 24 bajty na
+ * wiersz, a słowa multizbiorów ("zimna" część) tylko dla kandydatów o równych
+ * skrótach, przy ostatecznym sprawdzeniu podobieństwa.
+ * digest - skrót posortowanego multizbioru
+ * sizes - liczby słów czterech typów po 16 bitów (większe są obcinane)
+ * line - numer wiersza (0 - wiersz należy już do wypisanej grupy)
+ */
+struct hotLine {
+    uint64_t digest;
+    uint64_t sizes;
+    size_t line;
+};
+typedef struct hotLine hotLine;
+
+/**
+ * Zadanie sortowania jednego fragmentu tablicy.
+ * job - sortowana tablica
+ * index - numer fragmentu
+ */
+struct sortChunk {
+    sortJob *job;
+    size_t index;
+};
+typedef struct sortChunk sortChunk;
 
 /**
  * Funkcja porównująca dwie "nieliczby" do qsort.
@@ -65,9 +132,12 @@ static int compareUnsigInts(const void *a, const void *b) {
  * set1 - pierwszy multizbiór
  * set2 - drugi multizbiór
  */
-static bool similarNotNumbers(multiset set1, multiset set2) {
-    for (size_t j = 0; j < set1.sizeNotNumbers; j++) {
-        if (strcmp(set1.notNumbers[j], set2.notNumbers[j]) != 0)
+static bool similarNotNumbers(multiset *set1, multiset *set2) {
+    char **x = notNumbersOf(set1);
+    char **y = notNumbersOf(set2);
+
+    for (size_t j = 0; j < set1->sizeNotNumbers; j++) {
+        if (strcmp(x[j], y[j]) != 0)
             return false;
     }
 
@@ -80,11 +150,11 @@ static bool similarNotNumbers(multiset set1, multiset set2) {
  * set1 - pierwszy multizbiór
  * set2 - drugi multizbiór
  */
-static bool similarSizes(multiset set1, multiset set2) {
-    if (set1.sizeUnsigInts != set2.sizeUnsigInts ||
-        set1.sizeSigInts != set2.sizeSigInts ||
-        set1.sizeAnyFloats != set2.sizeAnyFloats ||
-        set1.sizeNotNumbers != set2.sizeNotNumbers) {
+static bool similarSizes(multiset *set1, multiset *set2) {
+    if (set1->sizeUnsigInts != set2->sizeUnsigInts ||
+        set1->sizeSigInts != set2->sizeSigInts ||
+        set1->sizeAnyFloats != set2->sizeAnyFloats ||
+        set1->sizeNotNumbers != set2->sizeNotNumbers) {
 
         return false;
     }
@@ -97,9 +167,12 @@ static bool similarSizes(multiset set1, multiset set2) {
  * set1 - pierwszy multizbiór
  * set2 - drugi multizbiór
  */
-static bool similarAnyFloats(multiset set1, multiset set2) {
-    for (size_t j = 0; j < set1.sizeAnyFloats; j++) {
-        if (set1.anyFloats[j] != set2.anyFloats[j])
+static bool similarAnyFloats(multiset *set1, multiset *set2) {
+    long double *x = anyFloatsOf(set1);
+    long double *y = anyFloatsOf(set2);
+
+    for (size_t j = 0; j < set1->sizeAnyFloats; j++) {
+        if (x[j] != y[j])
             return false;
     }
 
@@ -111,9 +184,12 @@ static bool similarAnyFloats(multiset set1, multiset set2) {
  * set1 - pierwszy multizbiór
  * set2 - drugi multizbiór
  */
-static bool similarSigInts(multiset set1, multiset set2) {
-    for (size_t j = 0; j < set1.sizeSigInts; j++) {
-        if (set1.sigInts[j] != set2.sigInts[j])
+static bool similarSigInts(multiset *set1, multiset *set2) {
+    long long *x = sigIntsOf(set1);
+    long long *y = sigIntsOf(set2);
+
+    for (size_t j = 0; j < set1->sizeSigInts; j++) {
+        if (x[j] != y[j])
             return false;
     }
 
@@ -125,9 +201,12 @@ static bool similarSigInts(multiset set1, multiset set2) {
  * set1 - pierwszy multizbiór
  * set2 - drugi multizbiór
  */
-static bool similarUnsigInts(multiset set1, multiset set2) {
-    for (size_t j = 0; j < set1.sizeUnsigInts; j++) {
-        if (set1.unsigInts[j] != set2.unsigInts[j])
+static bool similarUnsigInts(multiset *set1, multiset *set2) {
+    unsigned long long *x = unsigIntsOf(set1);
+    unsigned long long *y = unsigIntsOf(set2);
+
+    for (size_t j = 0; j < set1->sizeUnsigInts; j++) {
+        if (x[j] != y[j])
             return false;
     }
 
@@ -135,66 +214,405 @@ static bool similarUnsigInts(multiset set1, multiset set2) {
 }
 
 /**
- * Funkcja sprawdzająca czy dwa multizbiory są podobne.
+ * Funkcja sprawdzająca czy dwa posortowane multizbiory mają te same
+ * "nieliczby" oraz tyle samo liczb (bez względu na ich typ i wartość).
+ * set1 - pierwszy multizbiór
+ * set2 - drugi multizbiór
+ */
+bool similarWordParts(multiset *set1, multiset *set2) {
+    uint64_t numbers1 = (uint64_t) set1->sizeUnsigInts + set1->sizeSigInts
+                        + set1->sizeAnyFloats;
+    uint64_t numbers2 = (uint64_t) set2->sizeUnsigInts + set2->sizeSigInts
+                        + set2->sizeAnyFloats;
+
+    return (numbers1 == numbers2
+            && set1->sizeNotNumbers == set2->sizeNotNumbers
+            && similarNotNumbers(set1, set2));
+}
+
+/**
+ * Funkcja sprawdzająca czy dwa posortowane multizbiory są podobne.
+ * set1 - pierwszy multizbiór
+ * set2 - drugi multizbiór
  */
-static bool similarSets(multiset set1, multiset set2) {
+bool similarSets(multiset *set1, multiset *set2) {
     return (similarSizes(set1, set2) && similarUnsigInts(set1, set2) &&
             similarSigInts(set1, set2) && similarAnyFloats(set1, set2) &&
             similarNotNumbers(set1, set2));
 }
 
 /**
- * Funkcja wypisująca wszystkie podobne multizbiory zgodnie ze specyfikacją.
+ * Funkcja zwracająca liczbę słów nie większą niż HOT_SIZE_MAX.
+ * size - liczba słów
+ */
+static uint64_t hotSize(uint32_t size) {
+    return size < HOT_SIZE_MAX ? size : HOT_SIZE_MAX;
+}
+
+/**
+ * Funkcja znajdująca wszystkie grupy podobnych multizbiorów i przekazująca
+ * je kolejno, w kolejności pierwszych wierszy, do modułu wypisującego.
+ * Wiersze są porównywane najpierw po skrótach w zwartej tablicy, a pełne
+ * porównanie multizbiorów odbywa się tylko przy zgodnych skrótach.
  * set - wskaźnik na wszystkie multizbiory
  * size - ilość wszystkich multizbiorów
+ * r - moduł wypisujący grupy
  */
-void findSimilar(multiset *set, size_t size) {
-    size_t i, j;
-    // Tablica mówiąca, czy dany multizbiór był już wypisany
-    bool visited[size];
+void findSimilar(multiset *set, size_t size, reporter *r) {
+    size_t i, j, groupSize;
+    // Skróty wierszy - jedyne dane czytane w pętli wewnętrznej
+    hotLine *hot = malloc((size + 1) * sizeof(hotLine));
+    // Numery wierszy obecnie tworzonej grupy
+    size_t *lines = malloc((size + 1) * sizeof(size_t));
 
-    // Inicjalizacja tablicy na false
-    for (i = 0; i < size; i++ )
-        visited[i] = false;
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (hot == NULL || lines == NULL)
+        exit(1);
+
+    for (i = 0; i < size; i++) {
+        hot[i].digest = multisetDigest(&set[i]);
+        hot[i].sizes = hotSize(set[i].sizeUnsigInts)
+                       | hotSize(set[i].sizeSigInts) << 16
+                       | hotSize(set[i].sizeAnyFloats) << 32
+                       | hotSize(set[i].sizeNotNumbers) << 48;
+        hot[i].line = set[i].lineCount;
+    }
 
     for (i = 0; i < size; i++) {
-        if (!visited[i]) {
-            printf("%zu", set[i].lineCount);
+        if (hot[i].line != 0) {
+            groupSize = 0;
+            lines[groupSize++] = hot[i].line;
 
             for (j = i + 1; j < size; j++) {
-                if (!visited[j]) {
-                    if (similarSets(set[i], set[j])) {
-                        printf(" %zu", set[j].lineCount);
-                        visited[j] = true;
-                    }
+                if (hot[j].line != 0 && hot[j].digest == hot[i].digest
+                    && hot[j].sizes == hot[i].sizes
+                    && similarSets(&set[i], &set[j])) {
+                    lines[groupSize++] = hot[j].line;
+                    hot[j].line = 0;
                 }
             }
 
-            visited[i] = true;
-            printf("\n");
+            hot[i].line = 0;
+            reportGroup(r, lines, groupSize, &set[i]);
         }
     }
+
+    free(hot);
+    free(lines);
 }
 
 /**
- * Funkcja sortująca wszystkie multizbiory.
- * set - wskaźnik na wszystkie multizbiory
- * size - ilość multizbiorów
+ * Funkcja scalająca dwa sąsiednie posortowane ciągi słów do bufora.
+ * from - początek pierwszego ciągu, za którym leży drugi ciąg
+ * left, right - długości ciągów
+ * to - bufor na wynik
+ * typeSize - rozmiar słowa
+ * compare - funkcja porównująca słowa
+ */
+static void mergeRuns(const char *from, size_t left, size_t right, char *to,
+                      size_t typeSize, wordComparator compare) {
+    const char *x = from, *xEnd = from + left * typeSize;
+    const char *y = xEnd, *yEnd = xEnd + right * typeSize;
+
+    while (x < xEnd && y < yEnd) {
+        // Przy równych słowach najpierw lewy ciąg - scalanie jest stabilne
+        if (compare(y, x) < 0) {
+            memcpy(to, y, typeSize);
+            y += typeSize;
+        }
+        else {
+            memcpy(to, x, typeSize);
+            x += typeSize;
+        }
+
+        to += typeSize;
+    }
+
+    memcpy(to, x, (size_t) (xEnd - x));
+    memcpy(to + (xEnd - x), y, (size_t) (yEnd - y));
+}
+
+/**
+ * Funkcja scalająca posortowane fragmenty tablicy parami, z podwajaniem
+ * długości fragmentów, na przemian w tablicy i w buforze pomocniczym.
+ * job - sortowana tablica
+ */
+static void mergeChunks(sortJob *job) {
+    size_t size = job->count * job->typeSize;
+    char *buffer = malloc(size), *from = job->base, *to = buffer, *tmp;
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (buffer == NULL)
+        exit(1);
+
+    for (size_t width = PARALLEL_SORT_CHUNK; width < job->count; width *= 2) {
+        for (size_t i = 0; i < job->count; i += 2 * width) {
+            size_t left = job->count - i < width ? job->count - i : width;
+            size_t rest = job->count - i - left;
+            size_t right = rest < width ? rest : width;
+
+            mergeRuns(from + i * job->typeSize, left, right,
+                      to + i * job->typeSize, job->typeSize, job->compare);
+        }
+
+        tmp = from;
+        from = to;
+        to = tmp;
+    }
+
+    if (from != job->base)
+        memcpy(job->base, from, size);
+
+    free(buffer);
+}
+
+/**
+ * Zadanie puli sortujące jeden fragment tablicy. Ostatni posortowany
+ * fragment uruchamia scalanie całej tablicy i zwalnia zadanie.
+ * arg - fragment tablicy
+ * worker - numer wątku puli
+ */
+static void sortChunkTask(void *arg, size_t worker) {
+    sortChunk *chunk = arg;
+    sortJob *job = chunk->job;
+    size_t start = chunk->index * PARALLEL_SORT_CHUNK;
+    size_t count = job->count - start < PARALLEL_SORT_CHUNK
+                   ? job->count - start : PARALLEL_SORT_CHUNK;
+    (void) worker;
+
+    qsort(job->base + start * job->typeSize, count, job->typeSize,
+          job->compare);
+
+    if (atomic_fetch_sub_explicit(&job->remaining, 1,
+                                  memory_order_acq_rel) == 1) {
+        mergeChunks(job);
+        free(job);
+    }
+}
+
+/**
+ * Funkcja sortująca tablicę słów: małe tablice (albo wszystkie, gdy nie ma
+ * puli) od razu funkcją qsort, a duże jako osobne zadania dla fragmentów.
+ * base - tablica słów
+ * count - liczba słów
+ * typeSize - rozmiar słowa
+ * compare - funkcja porównująca słowa
+ * pool - pula wątków albo NULL
+ * worker - numer wątku puli wywołującego funkcję
  */
-multiset *sortAll(multiset *set, size_t size) {
-    for (size_t i = 0; i < size; i++) {
-        qsort(set[i].unsigInts, set[i].sizeUnsigInts,
-              sizeof(unsigned long long), compareUnsigInts);
+static void sortWords(void *base, size_t count, size_t typeSize,
+                      wordComparator compare, workerPool *pool,
+                      size_t worker) {
+    sortJob *job;
+    sortChunk *chunks;
 
-        qsort(set[i].sigInts, set[i].sizeSigInts,
-              sizeof(long long), compareSigInts);
+    if (pool == NULL || count < PARALLEL_SORT_MIN) {
+        qsort(base, count, typeSize, compare);
+        return;
+    }
+
+    // Zadanie i jego fragmenty leżą w jednym bloku, zwalnianym po scaleniu
+    job = malloc(sizeof(sortJob) + (count / PARALLEL_SORT_CHUNK + 1)
+                                   * sizeof(sortChunk));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (job == NULL)
+        exit(1);
+
+    chunks = (sortChunk *) (job + 1);
+    job->base = base;
+    job->count = count;
+    job->typeSize = typeSize;
+    job->compare = compare;
+    job->chunks = (count + PARALLEL_SORT_CHUNK - 1) / PARALLEL_SORT_CHUNK;
+    atomic_init(&job->remaining, job->chunks);
+
+    for (size_t i = 0; i < job->chunks; i++) {
+        chunks[i].job = job;
+        chunks[i].index = i;
+        poolSubmit(pool, worker, sortChunkTask, &chunks[i]);
+    }
+}
+
+/**
+ * Funkcja sortująca słowa każdego typu w multizbiorze, z tablicami bardzo
+ * długich wierszy sortowanymi równolegle przez pulę wątków. Sortowanie
+ * jest zakończone dopiero po poolWait.
+ * set - multizbiór
+ * pool - pula wątków
+ * worker - numer wątku puli wywołującego funkcję
+ */
+void sortMultisetTasks(multiset *set, workerPool *pool, size_t worker) {
+    sortWords(unsigIntsOf(set), set->sizeUnsigInts,
+              sizeof(unsigned long long), compareUnsigInts, pool, worker);
+
+    sortWords(sigIntsOf(set), set->sizeSigInts,
+              sizeof(long long), compareSigInts, pool, worker);
+
+    sortWords(anyFloatsOf(set), set->sizeAnyFloats,
+              sizeof(long double), compareAnyFloats, pool, worker);
+
+    sortWords(notNumbersOf(set), set->sizeNotNumbers,
+              sizeof(char *), compareNotNumbers, pool, worker);
+}
+
+/**
+ * Funkcja sortująca słowa każdego typu w multizbiorze.
+ * Po posortowaniu podobne multizbiory mają identyczne tablice słów.
+ * set - multizbiór
+ */
+void sortMultiset(multiset *set) {
+    sortMultisetTasks(set, NULL, 0);
+}
+
+/**
+ * Wiersze przekazane puli jako jedno zadanie etapu sortowania.
+ * set - multizbiory
+ * from, to - przedział numerów sortowanych wierszy
+ * pool - pula wątków
+ */
+struct sortRange {
+    multiset *set;
+    size_t from, to;
+    workerPool *pool;
+};
+typedef struct sortRange sortRange;
+
+/**
+ * Funkcja zwracająca liczbę słów multizbioru.
+ * set - multizbiór
+ */
+static size_t wordsOf(const multiset *set) {
+    return (size_t) set->sizeUnsigInts + set->sizeSigInts + set->sizeAnyFloats
+           + set->sizeNotNumbers;
+}
+
+/**
+ * Zadanie puli sortujące przedział wierszy. Tablice bardzo długiego wiersza
+ * są dzielone na fragmenty sortowane przez kolejne zadania.
+ * arg - przedział wierszy
+ * worker - numer wątku puli
+ */
+static void sortRangeTask(void *arg, size_t worker) {
+    sortRange *range = arg;
+
+    for (size_t i = range->from; i < range->to; i++)
+        sortMultisetTasks(&range->set[i], range->pool, worker);
+
+    free(range);
+}
+
+/**
+ * Funkcja przekazująca puli zadanie sortujące wiersze set[s->next..to).
+ * s - etap sortowania
+ * set - multizbiory
+ * to - numer pierwszego wiersza za przedziałem
+ */
+static void submitRange(sortStage *s, multiset *set, size_t to) {
+    sortRange *range;
+
+    if (s->next == to)
+        return;
+
+    range = malloc(sizeof(sortRange));
 
-        qsort(set[i].anyFloats, set[i].sizeAnyFloats,
-              sizeof(long double), compareAnyFloats);
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (range == NULL)
+        exit(1);
+
+    range->set = set;
+    range->from = s->next;
+    range->to = to;
+    range->pool = s->pool;
+    poolSubmit(s->pool, POOL_EXTERNAL, sortRangeTask, range);
+    s->next = to;
+    s->words = 0;
+}
+
+/**
+ * Funkcja przygotowująca etap sortowania wierszy. Przy jednym wątku nie
+ * tworzy puli - wiersze są sortowane od razu po przekazaniu, dopóki ich
+ * słowa są jeszcze w pamięci podręcznej procesora.
+ * s - etap sortowania
+ * threads - liczba wątków sortujących
+ */
+void sortStageInit(sortStage *s, size_t threads) {
+    s->pool = threads > 1 ? poolCreate(threads) : NULL;
+    s->next = 0;
+    s->added = 0;
+    s->words = 0;
+}
 
-        qsort(set[i].notNumbers, set[i].sizeNotNumbers,
-              sizeof(set[i].notNumbers), compareNotNumbers);
+/**
+ * Funkcja przekazująca do posortowania kolejne sparsowane multizbiory.
+ * Wiersze są zbierane w zadania o około SORT_STAGE_WORDS słowach, więc
+ * wielkość zadań zależy od liczby słów, a nie wierszy. Wiersz mający co
+ * najmniej tyle słów jest osobnym zadaniem, a jego duże tablice są dzielone
+ * między wątki, więc jeden długi wiersz nie wstrzymuje pracy pozostałych.
+ * Wolne wątki pobierają kolejne zadania na bieżąco.
+ * s - etap sortowania
+ * set - multizbiory
+ * size - liczba sparsowanych multizbiorów
+ */
+void sortStageAdd(sortStage *s, multiset *set, size_t size) {
+    size_t words;
+
+    for (; s->added < size; s->added++) {
+        if (s->pool == NULL) {
+            sortMultiset(&set[s->added]);
+            continue;
+        }
+
+        words = wordsOf(&set[s->added]);
+
+        if (words >= SORT_STAGE_WORDS) {
+            submitRange(s, set, s->added);
+            submitRange(s, set, s->added + 1);
+        }
+        else if ((s->words += words) >= SORT_STAGE_WORDS) {
+            submitRange(s, set, s->added + 1);
+        }
     }
+}
+
+/**
+ * Funkcja czekająca, aż pula posortuje wszystkie przekazane jej wiersze.
+ * s - etap sortowania
+ */
+void sortStageWait(sortStage *s) {
+    if (s->pool != NULL)
+        poolWait(s->pool);
+}
+
+/**
+ * Funkcja przekazująca puli ostatnie zebrane wiersze, czekająca na
+ * posortowanie wszystkich i kończąca pracę puli.
+ * s - etap sortowania
+ * set - multizbiory
+ * size - liczba multizbiorów
+ */
+void sortStageFinish(sortStage *s, multiset *set, size_t size) {
+    sortStageAdd(s, set, size);
+
+    if (s->pool != NULL) {
+        submitRange(s, set, size);
+        poolWait(s->pool);
+        poolDestroy(s->pool);
+        s->pool = NULL;
+    }
+}
+
+/**
+ * Funkcja sortująca wszystkie multizbiory w etapie sortowania o zadanej
+ * liczbie wątków.
+ * set - wskaźnik na wszystkie multizbiory
+ * size - ilość multizbiorów
+ * threads - liczba wątków sortujących
+ */
+multiset *sortAll(multiset *set, size_t size, size_t threads) {
+    sortStage s;
 
+    sortStageInit(&s, threads);
+    sortStageFinish(&s, set, size);
     return set;
 }
@@ -1,12 +1,59 @@
 #include "multiset.h"
+#include "report.h"
+#include "pool.h"
+#include <stdbool.h>
 
 #ifndef COMPARING_H
 #define COMPARING_H
 
-// Funkcja, która znajduje i wypisuje podobne wiersze
-extern void findSimilar(multiset *set, size_t size);
+/**
+ * Etap sortowania wierszy, którym parser przekazuje kolejne sparsowane
+ * multizbiory. Wiersze są sortowane w partiach o zbliżonej liczbie słów
+ * przez pulę wątków, równolegle z parsowaniem dalszych wierszy.
+ * pool - pula wątków (NULL - sortowanie od razu w wątku parsera)
+ * next - numer pierwszego wiersza, który nie trafił jeszcze do puli
+ * added - liczba wierszy przekazanych przez parser
+ * words - liczba słów wierszy od next do added
+ */
+struct sortStage {
+    workerPool *pool;
+    size_t next;
+    size_t added;
+    size_t words;
+};
+typedef struct sortStage sortStage;
 
-// Funkcja, która sortuje wszystkie multizbiory
-extern multiset *sortAll(multiset *set, size_t size);
+// Funkcja, która znajduje podobne wiersze i przekazuje je do wypisania
+extern void findSimilar(multiset *set, size_t size, reporter *r);
+
+// Funkcja, która sprawdza, czy dwa posortowane multizbiory są podobne
+extern bool similarSets(multiset *set1, multiset *set2);
+
+// Funkcja, która sprawdza, czy dwa posortowane multizbiory mają te same
+// "nieliczby" i tyle samo liczb
+extern bool similarWordParts(multiset *set1, multiset *set2);
+
+// Funkcja, która sortuje słowa jednego multizbioru
+extern void sortMultiset(multiset *set);
+
+// Funkcja, która sortuje słowa multizbioru, a tablice bardzo długich
+// wierszy w zadaniach puli wątków
+extern void sortMultisetTasks(multiset *set, workerPool *pool, size_t worker);
+
+// Funkcja przygotowująca etap sortowania wierszy w threads wątkach
+extern void sortStageInit(sortStage *s, size_t threads);
+
+// Funkcja przekazująca do posortowania kolejne multizbiory przed set[size]
+extern void sortStageAdd(sortStage *s, multiset *set, size_t size);
+
+// Funkcja czekająca na posortowanie przekazanych multizbiorów, np. przed
+// przeniesieniem ich tablicy w inne miejsce pamięci
+extern void sortStageWait(sortStage *s);
+
+// Funkcja sortująca pozostałe multizbiory i kończąca etap sortowania
+extern void sortStageFinish(sortStage *s, multiset *set, size_t size);
+
+// Funkcja, która sortuje wszystkie multizbiory w threads wątkach
+extern multiset *sortAll(multiset *set, size_t size, size_t threads);
 
 #endif //COMPARING_H
@@ -0,0 +1,75 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef SLOTS_H
+#define SLOTS_H
+
+/**
+ * Wspólne operacje tablic haszujących z adresowaniem otwartym i liniowym
+ * szukaniem: indeksu grup, okna, podsumowania najczęstszych grup, siatki
+ * tolerancji i słownika podobieństwa Jaccarda. Liczba miejsc tablicy jest
+ * potęgą dwójki. Tablice różnią się tylko zawartością miejsc, więc to, czy
+ * miejsce jest wolne i czy pasuje do szukanego elementu, sprawdza moduł
+ * tablicy.
+ */
+
+// Typ funkcji podającej skrót elementu z miejsca slot tablicy table,
+// zwracającej fałsz dla wolnego miejsca
+typedef bool (*slotDigest)(const void *table, size_t slot, uint64_t *digest);
+
+// Typ funkcji przenoszącej element tablicy table z miejsca from na miejsce to
+typedef void (*slotMove)(void *table, size_t to, size_t from);
+
+/**
+ * Funkcja zwracająca pierwsze miejsce, od którego szukany jest skrót.
+ * digest - skrót
+ * capacity - liczba miejsc tablicy
+ */
+static inline size_t slotHome(uint64_t digest, size_t capacity) {
+    return (size_t) digest & (capacity - 1);
+}
+
+/**
+ * Funkcja zwracająca miejsce sprawdzane po miejscu i.
+ * i - miejsce
+ * capacity - liczba miejsc tablicy
+ */
+static inline size_t slotNext(size_t i, size_t capacity) {
+    return (i + 1) & (capacity - 1);
+}
+
+/**
+ * Funkcja usuwająca element z miejsca i. Kolejne zajęte miejsca są
+ * przesuwane wstecz, aby nie przerwać ciągów szukania innych skrótów.
+ * Zwraca miejsce, które zostało wolne - moduł tablicy musi je oznaczyć.
+ * Jest w nagłówku, by przy stałych funkcjach digestAt i move kompilator
+ * mógł je wstawić w miejsce wywołań.
+ * table - tablica
+ * capacity - liczba miejsc tablicy
+ * i - usuwane miejsce
+ * digestAt - funkcja podająca skrót elementu z miejsca
+ * move - funkcja przenosząca element między miejscami
+ */
+static inline size_t slotRemove(void *table, size_t capacity, size_t i,
+                                slotDigest digestAt, slotMove move) {
+    size_t mask = capacity - 1;
+    size_t j = i;
+    uint64_t digest;
+
+    while (true) {
+        j = (j + 1) & mask;
+
+        if (!digestAt(table, j, &digest))
+            return i;
+
+        // Miejsce j może zostać przesunięte do i, jeśli jego pozycja
+        // docelowa nie leży cyklicznie w przedziale (i, j]
+        if (((j - slotHome(digest, capacity)) & mask) >= ((j - i) & mask)) {
+            move(table, i, j);
+            i = j;
+        }
+    }
+}
+
+#endif //SLOTS_H
@@ -2,7 +2,21 @@
 # Skrypt testujący małe zadanie z IPP pod wzgledem poprawności i braku
 # wycieków pamięci za pomocą programu valgrind. Przyjmuje 2 argumenty:
 # $1 - nazwa programu wykonywalnego
-# $2 - katalog z plikami do testowania
+# $2 - katalog z plikami do testowania (tests/ dla similar_lines,
+#      tests/decode/ dla similar_decode)
+# Jeśli obok pliku X.in leży plik X.args, jego zawartość jest przekazywana
+# programowi jako argumenty (np. testy trybów pracy, formatów wyników
+# i błędnych opcji w tests/; ścieżki są względne do katalogu uruchomienia).
+#
+# W trybie wydajnościowym (./test.sh program katalog --perf plik_bazowy)
+# każdy test jest uruchamiany RUNS razy, a mediana czasu i największy
+# szczytowy RSS są porównywane z plikiem bazowym. Test nie przechodzi, gdy
+# jest wolniejszy o więcej niż TIME_TOLERANCE procent lub zużywa więcej
+# pamięci o więcej niż MEMORY_TOLERANCE procent. Brakujące w pliku bazowym
+# testy są do niego dopisywane. Pomiarów dokonuje bench/measure (make bench),
+# a gdy go brakuje - /usr/bin/time. Test nie przechodzi również wtedy, gdy
+# program zakończy się niezerowym kodem wyjścia. Testy błędów (z niepustym
+# plikiem X.err) są w tym trybie pomijane.
 # Autor: Michał Skwarek
 
 PROGRAM=$1
@@ -13,6 +27,114 @@ BLANK='\033[0m'
 VALGRINDFLAGS="--error-exitcode=123 --leak-check=full --show-leak-kinds=all\
  --errors-for-leak-kinds=all"
 
+RUNS=${RUNS:-5}
+TIME_TOLERANCE=${TIME_TOLERANCE:-20}
+MEMORY_TOLERANCE=${MEMORY_TOLERANCE:-10}
+MEASURE="$(dirname "$0")/bench/measure"
+
+# Wypisuje argumenty programu dla testu $1 (zawartość pliku .args)
+arguments() {
+    if [ -f "${1%.in}.args" ]; then
+        cat "${1%.in}.args"
+    fi
+}
+
+# Uruchamia program na pliku $1 i wypisuje "czas_w_sekundach rss_w_kb".
+# Zwraca kod wyjścia programu.
+measure() {
+    local RESULT="$(mktemp)"
+    local STATUS
+
+    if [ -x "$MEASURE" ]; then
+        "$MEASURE" "$RESULT" ./$PROGRAM $(arguments "$1") <"$1" &>/dev/null
+    else
+        /usr/bin/time -f "%e %M" -o "$RESULT" ./$PROGRAM $(arguments "$1") \
+                      <"$1" &>/dev/null
+    fi
+    STATUS=$?
+
+    # /usr/bin/time poprzedza wynik informacją o niezerowym kodzie wyjścia
+    tail -n 1 "$RESULT"
+    rm -f "$RESULT"
+    return $STATUS
+}
+
+if [ "$3" == "--perf" ]; then
+    BASELINE=$4
+    FAILED=0
+
+    if [ -z "$BASELINE" ]; then
+        echo "Podaj plik bazowy: $0 program katalog --perf plik_bazowy"
+        exit 2
+    fi
+
+    if [ ! -x "$MEASURE" -a ! -x /usr/bin/time ]; then
+        echo "Brak narzedzia pomiarowego - uruchom make bench"
+        exit 2
+    fi
+
+    touch "$BASELINE"
+
+    for f in $DIRECTORY/*.in; do
+        NAME=${f#$DIRECTORY/};
+        TIMES=()
+
+        # Test błędu kończy program niezerowym kodem, zanim zacznie pracę
+        if [ -s "${f%.in}.err" ]; then
+            continue
+        fi
+        PEAK=0
+        CRASHED=0
+
+        for ((i = 0; i < RUNS; i++)); do
+            RESULT=$(measure "$f") || CRASHED=1
+            read TIME RSS <<<"$RESULT"
+            TIMES+=("$TIME")
+            ((RSS > PEAK)) && PEAK=$RSS
+        done
+
+        # Szybki, ale błędny przebieg nie może dać wyniku bazowego
+        if [ $CRASHED -eq 1 ]; then
+            echo -e "${RED}Test $NAME: program zakonczyl sie bledem${BLANK}"
+            ((FAILED+=1))
+            continue
+        fi
+
+        MEDIAN=$(printf "%s\n" "${TIMES[@]}" | sort -g \
+                 | awk '{ t[NR] = $1 } END { print t[int((NR + 1) / 2)] }')
+        read BASE_TIME BASE_RSS <<<"$(awk -v n="$NAME" \
+                                   '$1 == n { print $2, $3 }' "$BASELINE")"
+
+        if [ -z "$BASE_TIME" ]; then
+            echo "$NAME $MEDIAN $PEAK" >>"$BASELINE"
+            echo "Test $NAME: zapisano wynik bazowy ${MEDIAN}s, ${PEAK}kB"
+            continue
+        fi
+
+        VERDICT=$(awk -v t="$MEDIAN" -v m="$PEAK" -v bt="$BASE_TIME" \
+                  -v bm="$BASE_RSS" -v tt="$TIME_TOLERANCE" \
+                  -v mt="$MEMORY_TOLERANCE" 'BEGIN {
+                      v = "";
+                      if (t > bt * (1 + tt / 100)) v = v " czas";
+                      if (m > bm * (1 + mt / 100)) v = v " pamiec";
+                      print v }')
+
+        if [ -z "$VERDICT" ]; then
+            echo -e "${GREEN}Test $NAME: ${MEDIAN}s (bazowo ${BASE_TIME}s)," \
+                    "${PEAK}kB (bazowo ${BASE_RSS}kB)${BLANK}"
+        else
+            echo -e "${RED}Test $NAME - regresja:$VERDICT, ${MEDIAN}s" \
+                    "(bazowo ${BASE_TIME}s), ${PEAK}kB" \
+                    "(bazowo ${BASE_RSS}kB)${BLANK}"
+            ((FAILED+=1))
+        fi
+    done
+
+    echo "Liczba testow z regresja wydajnosci: $FAILED"
+    [ $FAILED -eq 0 ]
+    exit
+fi
+
 ALL=0
 CORRECT=0
 WRONG=0
@@ -25,7 +147,7 @@ for f in $DIRECTORY/*.in; do
 
     echo "Sprawdzam poprawnosc programu dla testu $NAME..."
 
-    ./$PROGRAM <"$f" 1>$OUTCOME.out 2>$OUTCOME.err
+    ./$PROGRAM $(arguments "$f") <"$f" 1>$OUTCOME.out 2>$OUTCOME.err
 
     diff "${f%.in}".out $OUTCOME.out &>/dev/null
     OUTPUT_CHECK=$?
@@ -46,7 +168,8 @@ for f in $DIRECTORY/*.in; do
 
     echo "Sprawdzam potencjalne wycieki pamieci...";
 
-    valgrind $VALGRINDFLAGS ./$PROGRAM <"$f" 1>/dev/null 2>/dev/null
+    valgrind $VALGRINDFLAGS ./$PROGRAM $(arguments "$f") <"$f" 1>/dev/null \
+        2>/dev/null
     VALGRIND_CHECK=$?
 
     if [ $VALGRIND_CHECK -eq 0 ];
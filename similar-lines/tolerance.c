@@ -0,0 +1,392 @@
+#include "tolerance.h"
+#include "multiset.h"
+#include "report.h"
+#include "similar.h"
+#include "digest.h"
+#include "slots.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+// Znacznik końca listy wierszy grupy
+#define NO_LINE ((size_t) -1)
+
+// Największa wartość bezwzględna położenia liczby na siatce, przy której
+// błąd zaokrąglenia położenia (kilka jednostek ostatniej pozycji long double,
+// czyli około 1e-4 komórki) mieści się w zapasie GRID_MARGIN
+#define GRID_LIMIT 5e14L
+
+/**
+ * Komórka siatki jednej liczby.
+ * negative - czy komórka leży na osi logarytmów liczb ujemnych (tylko przy
+ *            tolerancji względnej)
+ * cell - numer komórki
+ * neighbour - przesunięcie do sąsiedniej komórki, w której może leżeć liczba
+ *             równa z tolerancją (-1 lub 1), albo 0, gdy takiej nie ma
+ */
+struct gridCell {
+    bool negative;
+    int64_t cell;
+    int neighbour;
+};
+typedef struct gridCell gridCell;
+
+/**
+ * Kursor przeglądający rosnąco wszystkie liczby posortowanego multizbioru
+ * jako liczby zmiennoprzecinkowe. Liczba całkowita zapisana
+ * zmiennoprzecinkowo (np. 21.0) staje się przy rozpoznawaniu liczbą
+ * całkowitą, więc przy tolerancji liczby całkowite i zmiennoprzecinkowe są
+ * porównywane razem. Ujemne liczby całkowite poprzedzają nieujemne, więc
+ * wystarczy scalać ciąg liczb całkowitych z ciągiem zmiennoprzecinkowych.
+ * set - multizbiór
+ * ints - liczba przejrzanych liczb całkowitych (najpierw ujemnych)
+ * floats - liczba przejrzanych liczb zmiennoprzecinkowych
+ */
+struct numberCursor {
+    multiset *set;
+    uint64_t ints, floats;
+};
+typedef struct numberCursor numberCursor;
+
+/**
+ * Grupy wierszy podobnych z tolerancją wraz z tablicą haszującą kluczy.
+ * Grupa jest reprezentowana przez swój pierwszy wiersz. Kilka grup może
+ * mieć ten sam klucz - zajmują wtedy kolejne miejsca tablicy.
+ * first, last - indeksy pierwszego i ostatniego multizbioru grupy
+ * keys - klucze grup (skrót "nieliczb" i komórek reprezentanta)
+ * count - liczba grup
+ * next - indeks kolejnego multizbioru tej samej grupy dla każdego multizbioru
+ * slots - tablica haszująca: numer grupy zwiększony o 1, 0 - wolne miejsce
+ * capacity - liczba miejsc tablicy haszującej (potęga dwójki)
+ */
+struct gridIndex {
+    size_t *first, *last;
+    uint64_t *keys;
+    size_t count;
+    size_t *next;
+    size_t *slots;
+    size_t capacity;
+};
+typedef struct gridIndex gridIndex;
+
+/**
+ * Funkcja przygotowująca tolerancję. Komórki mają szerokość dwóch tolerancji
+ * (z zapasem), więc liczba równa z tolerancją danej liczbie leży w jej
+ * komórce albo w jednej sąsiedniej - tej bliższej liczbie.
+ * t - tolerancja
+ * epsilon - tolerancja (przy względnej mniejsza od 1)
+ * relative - czy tolerancja jest względna
+ */
+void toleranceInit(tolerance *t, long double epsilon, bool relative) {
+    t->epsilon = epsilon;
+    t->relative = relative;
+
+    // Przy tolerancji względnej |x| i |y| różnią się najwyżej o czynnik
+    // 1 - epsilon, czyli ich logarytmy o -log(1 - epsilon)
+    if (relative)
+        t->width = -2 * log1pl(-epsilon) * (1 + GRID_MARGIN);
+    else
+        t->width = 2 * epsilon * (1 + GRID_MARGIN);
+}
+
+/**
+ * Funkcja wyznaczająca komórkę siatki liczby. Liczby nieskończone i zero przy
+ * tolerancji względnej mogą być równe tylko sobie samym - nie mają komórki
+ * sąsiedniej. Liczby, których położenie przekracza GRID_LIMIT (szerokość
+ * komórki jest wtedy bliska dokładności long double), trafiają do wspólnej
+ * komórki brzegowej, w której wszyscy kandydaci są sprawdzani parami - liczba
+ * równa z tolerancją liczbie tuż przed brzegiem ma ją za komórkę sąsiednią.
+ * Numery komórek mogą się pokrywać z innymi, co jedynie dodaje kandydatów
+ * do sprawdzenia.
+ * x - liczba
+ * t - tolerancja
+ */
+static gridCell cellOf(long double x, const tolerance *t) {
+    gridCell g = {false, 0, 0};
+    long double position, cell;
+
+    if (!isfinite(x)) {
+        g.cell = isnan(x) ? 0 : x > 0 ? INT64_MAX : INT64_MIN;
+        return g;
+    }
+
+    if (t->relative && x == 0)
+        return g;
+
+    position = t->relative ? logl(fabsl(x)) / t->width : x / t->width;
+    cell = floorl(position);
+
+    // Liczby ujemne i dodatnie leżą przy tolerancji względnej na osobnych
+    // osiach logarytmów
+    g.negative = t->relative && x < 0;
+
+    if (cell >= GRID_LIMIT) {
+        g.cell = (int64_t) GRID_LIMIT;
+        g.neighbour = cell == GRID_LIMIT && position - cell < 0.5L ? -1 : 0;
+        return g;
+    }
+
+    if (cell <= -GRID_LIMIT) {
+        g.cell = (int64_t) -GRID_LIMIT;
+        g.neighbour = cell == -GRID_LIMIT && position - cell >= 0.5L ? 1 : 0;
+        return g;
+    }
+
+    g.cell = (int64_t) cell;
+    g.neighbour = position - cell < 0.5L ? -1 : 1;
+
+    return g;
+}
+
+/**
+ * Funkcja zwracająca łączną liczbę liczb multizbioru.
+ * x - multizbiór
+ */
+static uint64_t numbersOf(multiset *x) {
+    return (uint64_t) x->sizeUnsigInts + x->sizeSigInts + x->sizeAnyFloats;
+}
+
+/**
+ * Funkcja zwracająca kolejną liczbę całkowitą kursora jako liczbę
+ * zmiennoprzecinkową (long double mieści dokładnie 64-bitowe liczby).
+ * c - kursor, który nie przejrzał jeszcze wszystkich liczb całkowitych
+ */
+static long double intAt(const numberCursor *c) {
+    if (c->ints < c->set->sizeSigInts)
+        return (long double) sigIntsOf(c->set)[c->ints];
+
+    return (long double) unsigIntsOf(c->set)[c->ints - c->set->sizeSigInts];
+}
+
+/**
+ * Funkcja zwracająca kolejną liczbę multizbioru i przesuwająca kursor.
+ * c - kursor, który nie przejrzał jeszcze wszystkich liczb
+ */
+static long double nextNumber(numberCursor *c) {
+    multiset *x = c->set;
+    uint64_t ints = (uint64_t) x->sizeSigInts + x->sizeUnsigInts;
+    long double value;
+
+    if (c->ints < ints && (c->floats == x->sizeAnyFloats
+                           || intAt(c) <= anyFloatsOf(x)[c->floats])) {
+        value = intAt(c);
+        c->ints++;
+    }
+    else {
+        value = anyFloatsOf(x)[c->floats++];
+    }
+
+    return value;
+}
+
+/**
+ * Funkcja sprawdzająca, czy dwie liczby są równe z tolerancją.
+ * x, y - liczby
+ * t - tolerancja
+ */
+static bool withinTolerance(long double x, long double y,
+                            const tolerance *t) {
+    if (!isfinite(x) || !isfinite(y))
+        return x == y;
+    else if (t->relative)
+        return fabsl(x - y) <= t->epsilon * fmaxl(fabsl(x), fabsl(y));
+    else
+        return fabsl(x - y) <= t->epsilon;
+}
+
+/**
+ * Funkcja sprawdzająca, czy dwa posortowane multizbiory są podobne
+ * z tolerancją. Wszystkie liczby są porównywane rosnąco parami - jeśli da
+ * się je połączyć w pary równe z tolerancją, to połączenie w kolejności
+ * posortowania też jest takie.
+ * set1 - pierwszy multizbiór
+ * set2 - drugi multizbiór
+ * t - tolerancja
+ */
+static bool similarWithin(multiset *set1, multiset *set2, const tolerance *t) {
+    numberCursor c1 = {set1, 0, 0}, c2 = {set2, 0, 0};
+    uint64_t numbers = numbersOf(set1);
+
+    if (!similarWordParts(set1, set2))
+        return false;
+
+    for (uint64_t i = 0; i < numbers; i++) {
+        if (!withinTolerance(nextNumber(&c1), nextNumber(&c2), t))
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * Funkcja obliczająca klucz dla wybranych komórek siatki. Bit j maski
+ * oznacza, że j-ta liczba bierze komórkę sąsiednią zamiast własnej.
+ * exact - skrót "nieliczb" multizbioru
+ * cells - komórki pierwszych liczb
+ * k - liczba komórek
+ * mask - maska wyboru komórek sąsiednich
+ */
+static uint64_t keyOf(uint64_t exact, const gridCell *cells, size_t k,
+                      unsigned mask) {
+    uint64_t h = exact;
+
+    for (size_t j = 0; j < k; j++) {
+        h = digestCombine(h, cells[j].negative);
+        h = digestCombine(h, (uint64_t) (cells[j].cell
+                                         + ((mask >> j) & 1
+                                            ? cells[j].neighbour : 0)));
+    }
+
+    return h;
+}
+
+/**
+ * Funkcja umieszczająca grupę na pierwszym wolnym miejscu dla jej klucza.
+ * x - indeks
+ * group - numer grupy
+ */
+static void placeGroup(gridIndex *x, size_t group) {
+    size_t i = slotHome(x->keys[group], x->capacity);
+
+    while (x->slots[i] != 0)
+        i = slotNext(i, x->capacity);
+
+    x->slots[i] = group + 1;
+}
+
+/**
+ * Funkcja dodająca nową grupę do tablicy haszującej, podwajając ją, gdy jest
+ * zapełniona w połowie.
+ * x - indeks
+ */
+static void insertGroup(gridIndex *x) {
+    if (2 * (x->count + 1) > x->capacity) {
+        free(x->slots);
+        x->capacity *= 2;
+        x->slots = calloc(x->capacity, sizeof(size_t));
+
+        // Awaryjne wyjście z programu w przypadku braku pamięci
+        if (x->slots == NULL)
+            exit(1);
+
+        for (size_t g = 0; g < x->count; g++)
+            placeGroup(x, g);
+    }
+
+    placeGroup(x, x->count++);
+}
+
+/**
+ * Funkcja szukająca najwcześniejszej grupy o danym kluczu, której
+ * reprezentant jest podobny z tolerancją do multizbioru.
+ * x - indeks
+ * set - wszystkie multizbiory
+ * i - indeks multizbioru
+ * key - klucz
+ * best - dotychczas najlepsza grupa (count, gdy brak), aktualizowana
+ * t - tolerancja
+ */
+static void probe(gridIndex *x, multiset *set, size_t i, uint64_t key,
+                  size_t *best, const tolerance *t) {
+    size_t slot = slotHome(key, x->capacity), g;
+
+    while (x->slots[slot] != 0) {
+        g = x->slots[slot] - 1;
+
+        if (x->keys[g] == key && g < *best
+            && similarWithin(&set[x->first[g]], &set[i], t))
+            *best = g;
+
+        slot = slotNext(slot, x->capacity);
+    }
+}
+
+/**
+ * Funkcja znajdująca grupy wierszy podobnych z tolerancją dla liczb.
+ * Wiersz dołącza do najwcześniejszej grupy, której pierwszy wiersz jest do
+ * niego podobny. Grupy są szukane w tablicy haszującej po kluczu ze skrótu
+ * "nieliczb" i komórek siatki pierwszych GRID_FLOATS liczb - sprawdzane jest najwyżej 2^GRID_FLOATS kluczy
+ * (własne komórki i komórki sąsiednie), więc czas jest prawie liniowy
+ * zamiast kwadratowego. Grupy są przekazywane w kolejności pierwszych
+ * wierszy.
+ * set - posortowane multizbiory w kolejności wierszy
+ * size - liczba multizbiorów
+ * r - moduł wypisujący grupy
+ * t - tolerancja
+ */
+void findSimilarWithin(multiset *set, size_t size, reporter *r,
+                       const tolerance *t) {
+    gridIndex x;
+    gridCell cells[GRID_FLOATS];
+    numberCursor cursor;
+    size_t k, best, *lines, count;
+    uint64_t exact;
+    unsigned usable, mask;
+
+    x.first = malloc((size + 1) * sizeof(size_t));
+    x.last = malloc((size + 1) * sizeof(size_t));
+    x.keys = malloc((size + 1) * sizeof(uint64_t));
+    x.next = malloc((size + 1) * sizeof(size_t));
+    x.count = 0;
+    x.capacity = GRID_DEFAULT_SLOTS;
+    x.slots = calloc(x.capacity, sizeof(size_t));
+    lines = malloc((size + 1) * sizeof(size_t));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (x.first == NULL || x.last == NULL || x.keys == NULL || x.next == NULL
+        || x.slots == NULL || lines == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < size; i++) {
+        exact = multisetDigestWords(&set[i]);
+        cursor = (numberCursor) {&set[i], 0, 0};
+        k = numbersOf(&set[i]) < GRID_FLOATS ? numbersOf(&set[i])
+                                             : GRID_FLOATS;
+        usable = 0;
+
+        for (size_t j = 0; j < k; j++) {
+            cells[j] = cellOf(nextNumber(&cursor), t);
+
+            if (cells[j].neighbour != 0)
+                usable |= 1u << j;
+        }
+
+        // Przegląd wszystkich podzbiorów liczb, które mają komórkę sąsiednią
+        best = x.count;
+        mask = 0;
+
+        do {
+            probe(&x, set, i, keyOf(exact, cells, k, mask), &best, t);
+            mask = (mask - usable) & usable;
+        } while (mask != 0);
+
+        x.next[i] = NO_LINE;
+
+        if (best < x.count) {
+            x.next[x.last[best]] = i;
+            x.last[best] = i;
+        }
+        else {
+            x.first[x.count] = i;
+            x.last[x.count] = i;
+            x.keys[x.count] = keyOf(exact, cells, k, 0);
+            insertGroup(&x);
+        }
+    }
+
+    for (size_t g = 0; g < x.count; g++) {
+        count = 0;
+
+        for (size_t i = x.first[g]; i != NO_LINE; i = x.next[i])
+            lines[count++] = set[i].lineCount;
+
+        reportGroup(r, lines, count, &set[x.first[g]]);
+    }
+
+    free(x.first);
+    free(x.last);
+    free(x.keys);
+    free(x.next);
+    free(x.slots);
+    free(lines);
+}
@@ -0,0 +1,46 @@
+#include "multiset.h"
+#include "report.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef TOLERANCE_H
+#define TOLERANCE_H
+
+// Liczba pierwszych liczb multizbioru, których komórki siatki wyznaczają
+// jego klucz - pozostałe są tylko porównywane
+#define GRID_FLOATS 6
+
+// Względny zapas szerokości komórki, chroniący przed błędami zaokrągleń
+// przy wyznaczaniu położenia liczby na siatce
+#define GRID_MARGIN 1e-3L
+
+// Początkowa liczba miejsc w tablicy haszującej komórek
+#define GRID_DEFAULT_SLOTS 64
+
+/**
+ * Tolerancja porównywania liczb - zmiennoprzecinkowych i całkowitych, bo
+ * liczba całkowita zapisana zmiennoprzecinkowo jest rozpoznawana jako
+ * całkowita. Przy tolerancji bezwzględnej liczby x i y są równe, gdy
+ * |x - y| <= epsilon, a przy względnej, gdy
+ * |x - y| <= epsilon * max(|x|, |y|).
+ * epsilon - tolerancja
+ * relative - czy tolerancja jest względna
+ * width - szerokość komórki siatki: na osi liczb albo, przy tolerancji
+ *         względnej, na osi logarytmów wartości bezwzględnych
+ */
+struct tolerance {
+    long double epsilon;
+    bool relative;
+    long double width;
+};
+typedef struct tolerance tolerance;
+
+// Funkcja przygotowująca tolerancję i szerokość komórek siatki
+extern void toleranceInit(tolerance *t, long double epsilon, bool relative);
+
+// Funkcja znajdująca grupy wierszy podobnych z tolerancją dla liczb
+// i przekazująca je do wypisania
+extern void findSimilarWithin(multiset *set, size_t size, reporter *r,
+                              const tolerance *t);
+
+#endif //TOLERANCE_H
@@ -0,0 +1,240 @@
+// Flaga potrzebna do poprawnego działania funkcji clock_gettime
+#define _GNU_SOURCE
+
+#include "window.h"
+#include "parser.h"
+#include "reader.h"
+#include "arena.h"
+#include "slots.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Funkcja przydzielająca pustą tablicę haszującą o co najmniej dwa razy
+ * większej liczbie miejsc niż bufor okna.
+ * w - okno
+ */
+static void allocateCounts(slidingWindow *w) {
+    w->slots = 1;
+
+    while (w->slots < 2 * w->capacity)
+        w->slots *= 2;
+
+    w->counts = calloc(w->slots, sizeof(windowCount));
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (w->counts == NULL)
+        exit(1);
+}
+
+/**
+ * Funkcja przygotowująca puste okno.
+ * w - okno
+ * capacity - początkowa liczba miejsc bufora
+ */
+static void windowInit(slidingWindow *w, size_t capacity) {
+    w->entries = malloc(capacity * sizeof(windowEntry));
+    w->first = 0;
+    w->size = 0;
+    w->capacity = capacity;
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (w->entries == NULL)
+        exit(1);
+
+    allocateCounts(w);
+}
+
+/**
+ * Funkcja szukająca skrótu w tablicy haszującej. Zwraca miejsce skrótu
+ * albo pierwsze wolne miejsce.
+ * w - okno
+ * digest - skrót
+ */
+static size_t findCount(slidingWindow *w, uint64_t digest) {
+    size_t i = slotHome(digest, w->slots);
+
+    while (w->counts[i].count != 0 && w->counts[i].digest != digest)
+        i = slotNext(i, w->slots);
+
+    return i;
+}
+
+/**
+ * Funkcja podająca skrót z miejsca tablicy haszującej okna.
+ * table - okno
+ * slot - miejsce
+ * digest - miejsce na skrót
+ */
+static bool countDigest(const void *table, size_t slot, uint64_t *digest) {
+    const slidingWindow *w = table;
+
+    *digest = w->counts[slot].digest;
+    return w->counts[slot].count != 0;
+}
+
+/**
+ * Funkcja przenosząca licznik skrótu między miejscami tablicy haszującej.
+ * table - okno
+ * to - miejsce docelowe
+ * from - miejsce źródłowe
+ */
+static void moveCount(void *table, size_t to, size_t from) {
+    slidingWindow *w = table;
+
+    w->counts[to] = w->counts[from];
+}
+
+/**
+ * Funkcja usuwająca miejsce z tablicy haszującej.
+ * w - okno
+ * i - usuwane miejsce
+ */
+static void removeCount(slidingWindow *w, size_t i) {
+    i = slotRemove(w, w->slots, i, countDigest, moveCount);
+    w->counts[i].count = 0;
+}
+
+/**
+ * Funkcja usuwająca z okna najstarszy wiersz.
+ * w - okno
+ */
+static void evictOldest(slidingWindow *w) {
+    size_t i = findCount(w, w->entries[w->first].digest);
+
+    if (--w->counts[i].count == 0)
+        removeCount(w, i);
+
+    w->first = (w->first + 1) % w->capacity;
+    --w->size;
+}
+
+/**
+ * Funkcja podwajająca bufor okna ograniczonego tylko czasem. Wiersze są
+ * przepisywane od najstarszego, a tablica haszująca budowana od nowa.
+ * w - okno
+ */
+static void growWindow(slidingWindow *w) {
+    windowEntry *entries = malloc(2 * w->capacity * sizeof(windowEntry));
+    windowCount *old = w->counts;
+    size_t oldSlots = w->slots;
+
+    // Awaryjne wyjście z programu w przypadku braku pamięci
+    if (entries == NULL)
+        exit(1);
+
+    for (size_t i = 0; i < w->size; i++)
+        entries[i] = w->entries[(w->first + i) % w->capacity];
+
+    free(w->entries);
+    w->entries = entries;
+    w->first = 0;
+    w->capacity *= 2;
+    allocateCounts(w);
+
+    for (size_t i = 0; i < oldSlots; i++) {
+        if (old[i].count != 0)
+            w->counts[findCount(w, old[i].digest)] = old[i];
+    }
+
+    free(old);
+}
+
+/**
+ * Funkcja dodająca wiersz na koniec okna. Zwraca numer ostatniego
+ * wcześniejszego wiersza okna o tym samym skrócie albo 0, gdy takiego
+ * wiersza nie ma.
+ * w - okno, w którym jest wolne miejsce
+ * digest - skrót multizbioru wiersza
+ * line - numer wiersza
+ * time - chwila wczytania wiersza
+ */
+static size_t windowAdd(slidingWindow *w, uint64_t digest, size_t line,
+                        double time) {
+    size_t i = findCount(w, digest);
+    size_t previous = w->counts[i].count != 0 ? w->counts[i].last : 0;
+    windowEntry *e = &w->entries[(w->first + w->size) % w->capacity];
+
+    e->digest = digest;
+    e->line = line;
+    e->time = time;
+    ++w->size;
+
+    w->counts[i].digest = digest;
+    w->counts[i].last = line;
+    ++w->counts[i].count;
+
+    return previous;
+}
+
+/**
+ * Funkcja zwalniająca pamięć okna.
+ * w - okno
+ */
+static void windowFree(slidingWindow *w) {
+    free(w->entries);
+    free(w->counts);
+}
+
+/**
+ * Funkcja zwracająca bieżącą chwilę zegara CLOCK_MONOTONIC w sekundach.
+ */
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec / 1e9;
+}
+
+/**
+ * Funkcja wyszukująca powtórzenia w oknie ostatnich wierszy nieskończonego
+ * strumienia. Okno obejmuje opts->window ostatnich wierszy i (lub) wiersze
+ * wczytane w ciągu ostatnich opts->windowSeconds sekund. Dla każdego wiersza
+ * N podobnego do wiersza z okna wypisywany jest od razu wiersz "N M", gdzie
+ * M to ostatni wcześniejszy wiersz okna o tym samym skrócie multizbioru.
+ * Wiersze są rozróżniane po 64-bitowym skrócie, więc okno nie przechowuje
+ * ich słów.
+ * opts - opcje programu
+ * process - funkcja przetwarzająca słowa według wybranych reguł
+ */
+void runWindow(const options *opts, wordProcessor process) {
+    arena *memory = arenaCreate();
+    lineReader *reader = readerCreate(STDIN_FILENO);
+    double time, seconds = (double) opts->windowSeconds;
+    size_t number, previous;
+    slidingWindow w;
+    uint64_t digest;
+    parser p;
+
+    // Okno W wierszy potrzebuje miejsca także na wiersz właśnie dodawany
+    windowInit(&w, opts->window > 0 ? opts->window + 1 : WINDOW_DEFAULT_SIZE);
+    parserInit(&p, reader, memory, process, true);
+    // Powtórzenia w strumieniu są potrzebne od razu, a nie po zapełnieniu
+    // bufora wyjścia
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    while (parseDigest(&p, &digest, &number)) {
+        time = now();
+
+        while (opts->windowSeconds > 0 && w.size > 0
+               && time - w.entries[w.first].time > seconds)
+            evictOldest(&w);
+
+        if (w.size == w.capacity)
+            growWindow(&w);
+
+        previous = windowAdd(&w, digest, number, time);
+
+        if (opts->window > 0 && w.size > opts->window)
+            evictOldest(&w);
+
+        if (previous != 0)
+            printf("%zu %zu\n", number, previous);
+    }
+
+    readerDestroy(reader);
+    arenaDestroy(memory);
+    windowFree(&w);
+}
@@ -0,0 +1,62 @@
+#include "options.h"
+#include "recognizer.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef WINDOW_H
+#define WINDOW_H
+
+// Początkowa liczba wierszy okna ograniczonego tylko czasem
+#define WINDOW_DEFAULT_SIZE 1024
+
+/**
+ * Wiersz w oknie.
+ * digest - skrót multizbioru wiersza
+ * line - numer wiersza
+ * time - chwila wczytania wiersza (w sekundach zegara CLOCK_MONOTONIC)
+ */
+struct windowEntry {
+    uint64_t digest;
+    size_t line;
+    double time;
+};
+typedef struct windowEntry windowEntry;
+
+/**
+ * Liczba wierszy okna o danym skrócie.
+ * digest - skrót multizbioru
+ * count - liczba wierszy okna o tym skrócie
+ * last - numer ostatniego wiersza okna o tym skrócie
+ */
+struct windowCount {
+    uint64_t digest;
+    size_t count;
+    size_t last;
+};
+typedef struct windowCount windowCount;
+
+/**
+ * Okno ostatnich wierszy: kolejka FIFO w buforze cyklicznym i tablica
+ * haszująca z liczbami wierszy okna o danym skrócie. Pamięć zależy tylko od
+ * rozmiaru okna, a koszt wiersza nie zależy od długości strumienia.
+ * entries - bufor cykliczny wierszy okna
+ * first - miejsce najstarszego wiersza w buforze
+ * size - liczba wierszy okna
+ * capacity - liczba miejsc bufora
+ * counts - tablica haszująca (count == 0 oznacza wolne miejsce)
+ * slots - liczba miejsc tablicy haszującej (potęga dwójki)
+ */
+struct slidingWindow {
+    windowEntry *entries;
+    size_t first;
+    size_t size;
+    size_t capacity;
+    windowCount *counts;
+    size_t slots;
+};
+typedef struct slidingWindow slidingWindow;
+
+// Funkcja wypisująca wiersze powtarzające wiersze z okna ostatnich wierszy
+extern void runWindow(const options *opts, wordProcessor process);
+
+#endif //WINDOW_H